@@ -2,6 +2,7 @@
 #include <wayfire/output.hpp>
 #include <wayfire/signal-definitions.hpp>
 #include <wayfire/render-manager.hpp>
+#include <wayfire/animation-scheduler.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <type_traits>
 #include <map>
@@ -67,7 +68,7 @@ struct animation_hook : public animation_hook_base
     std::unique_ptr<animation_base> animation;
 
     /* Update animation right before each frame */
-    wf::effect_hook_t update_animation_hook = [=] ()
+    bool step_animation()
     {
         view->damage();
         bool result = animation->step();
@@ -75,9 +76,12 @@ struct animation_hook : public animation_hook_base
 
         if (!result)
         {
+            /* Destroys the hook, which removes it from the scheduler */
             stop_hook(false);
         }
-    };
+
+        return result;
+    }
 
     /**
      * Switch the output the view is being animated on, and update the lastly
@@ -87,13 +91,14 @@ struct animation_hook : public animation_hook_base
     {
         if (current_output)
         {
-            current_output->render->rem_effect(&update_animation_hook);
+            wf::animation_scheduler_t::get(current_output).remove(this);
         }
 
         if (new_output)
         {
-            new_output->render->add_effect(&update_animation_hook,
-                wf::OUTPUT_EFFECT_PRE);
+            wf::animation_scheduler_t::get(new_output).add(this,
+                "animate/" + name + ":" + std::to_string(view->get_id()),
+                [=] () { return step_animation(); });
         }
 
         current_output = new_output;
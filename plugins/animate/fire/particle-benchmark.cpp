@@ -0,0 +1,148 @@
+/**
+ * Compares the update step of the fire particles in the old array-of-structs
+ * layout (including the copy into the GPU buffers) with ParticleData.
+ *
+ * Usage: fire-benchmark [iterations]
+ */
+#include "particle-data.hpp"
+#include "bench-util.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace
+{
+/** The update step as it was done before ParticleData. */
+struct aos_system_t
+{
+    std::vector<Particle> ps;
+    std::vector<float> color, dark_color, radius, center;
+
+    explicit aos_system_t(size_t num) : ps(num), color(4 * num),
+        dark_color(4 * num), radius(num), center(2 * num)
+    {}
+
+    static void update(Particle& p)
+    {
+        const float slowdown = 0.8;
+        p.pos   += p.speed * 0.2f * slowdown;
+        p.speed += p.g * 0.3f * slowdown;
+        if (p.life != 0)
+        {
+            p.color.a /= p.life;
+        }
+
+        p.life    -= p.fade * 0.3 * slowdown;
+        p.radius   = p.base_radius * std::pow(p.life, 0.5);
+        p.color.a *= p.life;
+        p.g.x = (p.start_pos.x < p.pos.x) ? -1 : 1;
+        if (p.life <= 0)
+        {
+            p.pos = {-10000, -10000};
+        }
+    }
+
+    int update()
+    {
+        int died = 0;
+        for (size_t i = 0; i < ps.size(); i++)
+        {
+            if (ps[i].life <= 0)
+            {
+                continue;
+            }
+
+            update(ps[i]);
+            died += (ps[i].life <= 0);
+            for (int j = 0; j < 4; j++)
+            {
+                color[4 * i + j] = ps[i].color[j];
+                dark_color[4 * i + j] = ps[i].color[j] * 0.5;
+            }
+
+            center[2 * i]     = ps[i].pos[0];
+            center[2 * i + 1] = ps[i].pos[1];
+            radius[i] = ps[i].radius;
+        }
+
+        return died;
+    }
+};
+
+Particle random_particle(std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> dist(0, 1);
+
+    Particle p;
+    p.life = 1;
+    p.fade = 0.1 + 0.5 * dist(gen);
+    p.color     = {dist(gen), dist(gen), dist(gen), 1};
+    p.pos       = {400 * dist(gen), 300 * dist(gen)};
+    p.start_pos = p.pos;
+    p.speed     = {-10 + 20 * dist(gen), -25 + 30 * dist(gen)};
+    p.g = {-1, -3};
+    p.base_radius = p.radius = 12 + 6 * dist(gen);
+
+    return p;
+}
+
+/**
+ * Run the update until all particles are dead, respawning them, for the
+ * given number of steps.
+ *
+ * @return The average time per step, in microseconds.
+ */
+template<class Update, class Respawn>
+double run(int steps, Update update, Respawn respawn)
+{
+    double total_us = 0;
+    for (int i = 0; i < steps; i++)
+    {
+        if (i % 16 == 0)
+        {
+            respawn();
+        }
+
+        auto start = wf::bench::clock::now();
+        update();
+        total_us += wf::bench::elapsed_us(start);
+    }
+
+    return total_us / steps;
+}
+}
+
+int main(int argc, char **argv)
+{
+    int steps = (argc > 1) ? std::atoi(argv[1]) : 1000;
+    for (size_t count : {10'000, 100'000})
+    {
+        std::mt19937 gen(count);
+        std::vector<Particle> initial(count);
+        for (auto& p : initial)
+        {
+            p = random_particle(gen);
+        }
+
+        aos_system_t aos(count);
+        ParticleData soa;
+        soa.resize(count);
+
+        volatile int died = 0;
+        double aos_us = run(steps, [&] { died += aos.update(); },
+            [&] { aos.ps = initial; });
+        double soa_us = run(steps, [&] { died += soa.update(0, count); }, [&]
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                soa.set(i, initial[i]);
+            }
+        });
+
+        std::cout << count << " particles: AoS " << aos_us << " us/step, SoA " <<
+            soa_us << " us/step (" << aos_us / soa_us << "x)" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+#ifndef ANIMATION_FIRE_PARTICLE_DATA_HPP
+#define ANIMATION_FIRE_PARTICLE_DATA_HPP
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/* Initial state of a particle, filled in by the ParticleIniter */
+struct Particle
+{
+    float life = -1;
+    float fade;
+
+    float radius, base_radius;
+
+    glm::vec2 pos{0.0, 0.0}, speed{0.0, 0.0}, g{0.0, 0.0};
+    glm::vec2 start_pos;
+
+    glm::vec4 color{1.0, 1.0, 1.0, 1.0};
+};
+
+/**
+ * The state of all particles, in a structure-of-arrays layout so that the
+ * update loop can be vectorized by the compiler.
+ *
+ * center, radius and color are uploaded to the GPU as they are.
+ */
+struct ParticleData
+{
+    static constexpr int color_per_particle  = 4;
+    static constexpr int radius_per_particle = 1;
+    static constexpr int center_per_particle = 2;
+
+    std::vector<float> life, fade, base_radius, start_x;
+    std::vector<float> speed_x, speed_y, g_x, g_y;
+
+    std::vector<float> center, radius, color;
+
+    size_t size() const
+    {
+        return life.size();
+    }
+
+    void resize(size_t num)
+    {
+        life.resize(num, -1);
+        fade.resize(num);
+        base_radius.resize(num);
+        start_x.resize(num);
+        speed_x.resize(num);
+        speed_y.resize(num);
+        g_x.resize(num);
+        g_y.resize(num);
+
+        center.resize(center_per_particle * num);
+        radius.resize(radius_per_particle * num);
+        color.resize(color_per_particle * num);
+    }
+
+    void set(size_t i, const Particle& p)
+    {
+        life[i] = p.life;
+        fade[i] = p.fade;
+        base_radius[i] = p.base_radius;
+        start_x[i] = p.start_pos.x;
+        speed_x[i] = p.speed.x;
+        speed_y[i] = p.speed.y;
+        g_x[i] = p.g.x;
+        g_y[i] = p.g.y;
+
+        center[2 * i]     = p.pos.x;
+        center[2 * i + 1] = p.pos.y;
+        radius[i] = p.radius;
+        for (int j = 0; j < 4; j++)
+        {
+            color[4 * i + j] = p.color[j];
+        }
+    }
+
+    /**
+     * Advance the particles in [start, end) by one step.
+     * Different ranges may be updated in parallel.
+     *
+     * The loop has no branches so that the compiler can vectorize it. Dead
+     * particles go through the same computation, but they are kept outside
+     * of the visible area with zero radius and alpha until they are spawned
+     * again with set().
+     *
+     * @return The number of particles which died in this step.
+     */
+    int update(size_t start, size_t end)
+    {
+        return update_range(end - start, life.data() + start, fade.data() + start,
+            base_radius.data() + start, start_x.data() + start,
+            speed_x.data() + start, speed_y.data() + start,
+            g_x.data() + start, g_y.data() + start,
+            center.data() + 2 * start, radius.data() + start, color.data() + 4 * start);
+    }
+
+  private:
+    /* The arrays never overlap, which the compiler has to know in order to
+     * vectorize the loop without a runtime check for each pair of them. */
+    static int update_range(size_t n, float *__restrict life_,
+        const float *__restrict fade_, const float *__restrict base_radius_,
+        const float *__restrict start_x_, float *__restrict speed_x_,
+        float *__restrict speed_y_, float *__restrict g_x_,
+        const float *__restrict g_y_, float *__restrict center_,
+        float *__restrict radius_, float *__restrict color_)
+    {
+        const float slowdown = 0.8;
+
+        int died = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            const float old_life = life_[i];
+            const float new_life = old_life - fade_[i] * 0.3f * slowdown;
+            const float remaining = std::max(new_life, 0.0f);
+
+            const float x = center_[2 * i] + speed_x_[i] * 0.2f * slowdown;
+            const float y = center_[2 * i + 1] + speed_y_[i] * 0.2f * slowdown;
+            speed_x_[i] += g_x_[i] * 0.3f * slowdown;
+            speed_y_[i] += g_y_[i] * 0.3f * slowdown;
+            g_x_[i] = (start_x_[i] < x) ? -1.0f : 1.0f;
+
+            /* Dead particles are moved outside */
+            center_[2 * i]     = (new_life > 0) ? x : -10000.0f;
+            center_[2 * i + 1] = (new_life > 0) ? y : -10000.0f;
+
+            /* Alpha was scaled by the old life, scale it by the new one.
+             * For dead particles, both alpha and radius become 0. */
+            color_[4 * i + 3] *= remaining / std::max(old_life, 1e-6f);
+            radius_[i] = base_radius_[i] * std::sqrt(remaining);
+            life_[i]   = new_life;
+
+            died += (old_life > 0) & (new_life <= 0);
+        }
+
+        return died;
+    }
+};
+
+#endif /* end of include guard: ANIMATION_FIRE_PARTICLE_DATA_HPP */
@@ -1,43 +1,7 @@
 #include "particle.hpp"
 #include "shaders.hpp"
 #include <wayfire/core.hpp>
-#include <thread>
-
-void Particle::update(float time)
-{
-    if (life <= 0) // ignore
-    {
-        return;
-    }
-
-    const float slowdown = 0.8;
-
-    pos   += speed * 0.2f * slowdown;
-    speed += g * 0.3f * slowdown;
-
-    if (life != 0)
-    {
-        color.a /= life;
-    }
-
-    life    -= fade * 0.3 * slowdown;
-    radius   = base_radius * std::pow(life, 0.5);
-    color.a *= life;
-
-    if (start_pos.x < pos.x)
-    {
-        g.x = -1;
-    } else
-    {
-        g.x = 1;
-    }
-
-    if (life <= 0)
-    {
-        /* move outside */
-        pos = {-10000, -10000};
-    }
-}
+#include <wayfire/thread-pool.hpp>
 
 ParticleSystem::ParticleSystem(int particles)
 {
@@ -64,11 +28,13 @@ int ParticleSystem::spawn(int num)
 {
     // TODO: multithread this
     int spawned = 0;
-    for (size_t i = 0; i < ps.size() && spawned < num; i++)
+    for (size_t i = 0; i < data.size() && spawned < num; i++)
     {
-        if (ps[i].life <= 0)
+        if (data.life[i] <= 0)
         {
-            pinit_func(ps[i]);
+            Particle p;
+            pinit_func(p);
+            data.set(i, p);
             ++spawned;
             ++particles_alive;
         }
@@ -79,86 +45,31 @@ int ParticleSystem::spawn(int num)
 
 void ParticleSystem::resize(int num)
 {
-    if (num == (int)ps.size())
+    if (num == (int)data.size())
     {
         return;
     }
 
-    // TODO: multithread this
-    for (int i = num; i < (int)ps.size(); i++)
+    for (int i = num; i < (int)data.size(); i++)
     {
-        if (ps[i].life >= 0)
+        if (data.life[i] > 0)
         {
             --particles_alive;
         }
     }
 
-    ps.resize(num);
-
-    color.resize(color_per_particle * num);
-    dark_color.resize(color_per_particle * num);
-    radius.resize(radius_per_particle * num);
-    center.resize(center_per_particle * num);
+    data.resize(num);
 }
 
 int ParticleSystem::size()
 {
-    return ps.size();
+    return data.size();
 }
 
 void ParticleSystem::update_worker(float time, int start, int end)
 {
-    end = std::min(end, (int)ps.size());
-    for (int i = start; i < end; ++i)
-    {
-        if (ps[i].life <= 0)
-        {
-            continue;
-        }
-
-        // printf("%d\n", i);
-        ps[i].update(time);
-
-        if (ps[i].life <= 0)
-        {
-            --particles_alive;
-        }
-
-        for (int j = 0; j < 4; j++) // maybe use memcpy?
-        {
-            color[4 * i + j] = ps[i].color[j];
-            dark_color[4 * i + j] = ps[i].color[j] * 0.5;
-        }
-
-        // printf("center %d gets %f", 2 * i, ps[i].pos[0]);
-        center[2 * i]     = ps[i].pos[0];
-        center[2 * i + 1] = ps[i].pos[1];
-
-        radius[i] = ps[i].radius;
-    }
-}
-
-void ParticleSystem::exec_worker_threads(std::function<void(int, int)> spawn_worker)
-{
-// return spawn_worker(0, ps.size());
-
-    const int num_threads = std::thread::hardware_concurrency();
-    const int worker_load = (ps.size() + num_threads - 1) / num_threads;
-
-    std::thread workers[num_threads];
-    for (int i = 0; i < num_threads; i++)
-    {
-        int thread_start = i * worker_load;
-        int thread_end   = (i + 1) * worker_load;
-        thread_end = std::min(thread_end, (int)ps.size());
-
-        workers[i] = std::thread([=] () { spawn_worker(thread_start, thread_end); });
-    }
-
-    for (auto& w : workers)
-    {
-        w.join();
-    }
+    end = std::min(end, (int)data.size());
+    particles_alive -= data.update(start, end);
 }
 
 void ParticleSystem::update()
@@ -167,7 +78,8 @@ void ParticleSystem::update()
     float time = (wf::get_current_time() - last_update_msec) / 16.0;
     last_update_msec = wf::get_current_time();
 
-    exec_worker_threads([=] (int start, int end)
+    wf::thread_pool_t::get().parallel_for(data.size(), PARTICLES_PER_TASK,
+        [=] (size_t start, size_t end)
     {
         update_worker(time, start, end);
     });
@@ -200,31 +112,33 @@ void ParticleSystem::render(glm::mat4 matrix)
     program.attrib_pointer("position", 2, 0, vertex_data);
     program.attrib_divisor("position", 0);
 
-    program.attrib_pointer("radius", 1, 0, radius.data());
+    program.attrib_pointer("radius", 1, 0, data.radius.data());
     program.attrib_divisor("radius", 1);
 
-    program.attrib_pointer("center", 2, 0, center.data());
+    program.attrib_pointer("center", 2, 0, data.center.data());
     program.attrib_divisor("center", 1);
 
     // matrix
     program.uniformMatrix4f("matrix", matrix);
 
-    /* Darken the background */
-    program.attrib_pointer("color", 4, 0, dark_color.data());
+    program.attrib_pointer("color", 4, 0, data.color.data());
     program.attrib_divisor("color", 1);
 
+    /* Darken the background */
+    program.uniform1f("color_scale", 0.5);
+
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ZERO, GL_ONE_MINUS_SRC_ALPHA));
     program.uniform1f("smoothing", 0.7);
 
     // TODO: optimize shaders for this case
-    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, ps.size()));
+    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, data.size()));
 
     // particle color
-    program.attrib_pointer("color", 4, 0, color.data());
+    program.uniform1f("color_scale", 1.0);
     GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE));
     program.uniform1f("smoothing", 0.5);
-    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, ps.size()));
+    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, data.size()));
 
     GL_CALL(glDisable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
@@ -5,6 +5,7 @@
 #include <wayfire/output.hpp>
 #include <wayfire/opengl.hpp>
 #include <wayfire/render-manager.hpp>
+#include <wayfire/animation-scheduler.hpp>
 #include "animate.hpp"
 
 /* animates wake from suspend/startup by fading in the whole output */
@@ -14,21 +15,23 @@ class wf_system_fade
 
     wf::output_t *output;
 
-    wf::effect_hook_t damage_hook, render_hook;
+    wf::effect_hook_t render_hook;
 
   public:
     wf_system_fade(wf::output_t *out, int dur) :
         progression(wf::create_option<int>(dur)), output(out)
     {
-        damage_hook = [=] ()
-        { output->render->damage_whole(); };
-
         render_hook = [=] ()
         { render(); };
 
-        output->render->add_effect(&damage_hook, wf::OUTPUT_EFFECT_PRE);
+        /* Damaging the output keeps frames coming until finish() */
+        wf::animation_scheduler_t::get(output).add(this, "animate/system-fade",
+            [=] ()
+        {
+            output->render->damage_whole();
+            return true;
+        });
         output->render->add_effect(&render_hook, wf::OUTPUT_EFFECT_OVERLAY);
-        output->render->set_redraw_always();
         this->progression.animate(1, 0);
     }
 
@@ -51,9 +54,8 @@ class wf_system_fade
 
     void finish()
     {
-        output->render->rem_effect(&damage_hook);
+        wf::animation_scheduler_t::get(output).remove(this);
         output->render->rem_effect(&render_hook);
-        output->render->set_redraw_always(false);
 
         delete this;
     }
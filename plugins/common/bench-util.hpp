@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * Timing helpers shared by the benchmark executables. They are only built
+ * with -Dbenchmarks=true and are not installed.
+ */
+#include <chrono>
+
+namespace wf
+{
+namespace bench
+{
+using clock = std::chrono::steady_clock;
+
+/** @return The time since start, in microseconds. */
+inline double elapsed_us(clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(clock::now() - start).count();
+}
+
+/** @return The average time of a call to fn, in microseconds. */
+template<class Function>
+double average_us(int iterations, Function fn)
+{
+    auto start = clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        fn();
+    }
+
+    return elapsed_us(start) / iterations;
+}
+}
+}
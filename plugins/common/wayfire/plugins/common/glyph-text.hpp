@@ -0,0 +1,683 @@
+#pragma once
+
+#include <wayfire/opengl.hpp>
+#include <wayfire/config/types.hpp>
+#include <wayfire/plugins/common/shared-core-data.hpp>
+#include <cairo.h>
+#include <pango/pango.h>
+#include <pango/pangocairo.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wf
+{
+/**
+ * A cache of rasterized glyphs in a single OpenGL texture.
+ *
+ * Glyphs are rasterized with cairo once, the first time they are needed, and
+ * afterwards text is drawn as a batch of textured quads. When the atlas runs
+ * full, it is cleared and glyphs are rasterized again on demand.
+ *
+ * The atlas is shared by all plugins, see glyph_text_t.
+ */
+class glyph_atlas_t
+{
+  public:
+    static constexpr int ATLAS_SIZE = 1024;
+
+    /** A glyph in the atlas, all values are in pixels. */
+    struct glyph_t
+    {
+        /* Position and size in the atlas */
+        int x, y, width, height;
+        /* Offset of the top-left corner from the pen position on the baseline */
+        int bearing_x, bearing_y;
+    };
+
+    glyph_atlas_t()
+    {
+        context = pango_font_map_create_context(pango_cairo_font_map_get_default());
+    }
+
+    ~glyph_atlas_t()
+    {
+        clear_fonts();
+        g_object_unref(context);
+
+        OpenGL::render_begin();
+        if (tex != (GLuint) - 1)
+        {
+            GL_CALL(glDeleteTextures(1, &tex));
+        }
+
+        glyph_program.free_resources();
+        rect_program.free_resources();
+        OpenGL::render_end();
+    }
+
+    glyph_atlas_t(const glyph_atlas_t&) = delete;
+    glyph_atlas_t& operator =(const glyph_atlas_t&) = delete;
+
+    /** The context used for shaping text. */
+    PangoContext *get_context() const
+    {
+        return context;
+    }
+
+    /**
+     * Incremented every time the atlas is cleared, which invalidates all
+     * glyphs returned by get_glyph().
+     */
+    uint64_t get_generation() const
+    {
+        return generation;
+    }
+
+    /**
+     * Find the given glyph in the atlas, rasterizing it if necessary.
+     *
+     * @return The glyph, or nullptr if it has no visible pixels or does not
+     *   fit in the atlas at all.
+     */
+    const glyph_t *get_glyph(PangoFont *font, PangoGlyph glyph)
+    {
+        uint64_t key = ((uint64_t)get_font_id(font) << 32) | glyph;
+        auto it = glyphs.find(key);
+        if (it != glyphs.end())
+        {
+            return it->second.width ? &it->second : nullptr;
+        }
+
+        return rasterize(key, font, glyph);
+    }
+
+    /**
+     * Upload the glyphs rasterized since the last call and bind the texture
+     * and the program for drawing glyphs.
+     *
+     * Requires bound opengl context.
+     */
+    void use_glyph_program(const glm::mat4& matrix, const glm::vec4& color)
+    {
+        ensure_gl_resources();
+        upload();
+
+        glyph_program.use(wf::TEXTURE_TYPE_RGBA);
+        GL_CALL(glActiveTexture(GL_TEXTURE0));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+        glyph_program.uniform1i("atlas", 0);
+        glyph_program.uniformMatrix4f("MVP", matrix);
+        glyph_program.uniform4f("color", color);
+    }
+
+    OpenGL::program_t& get_glyph_program()
+    {
+        return glyph_program;
+    }
+
+    /**
+     * Draw a filled rectangle with rounded corners.
+     *
+     * Requires bound opengl context.
+     *
+     * @param box The rectangle, in the coordinate system of @matrix.
+     * @param scale The number of pixels per unit of @box.
+     * @param radius The corner radius, in pixels.
+     */
+    void render_rounded_rectangle(const glm::mat4& matrix, wf::geometry_t box,
+        float scale, float radius, const glm::vec4& color)
+    {
+        ensure_gl_resources();
+
+        float w = box.width * scale / 2.0f;
+        float h = box.height * scale / 2.0f;
+        GLfloat vertex[] = {
+            (float)box.x, float(box.y + box.height),
+            float(box.x + box.width), float(box.y + box.height),
+            float(box.x + box.width), (float)box.y,
+            (float)box.x, (float)box.y,
+        };
+        GLfloat relative[] = {
+            -w, h,
+            w, h,
+            w, -h,
+            -w, -h,
+        };
+
+        rect_program.use(wf::TEXTURE_TYPE_RGBA);
+        rect_program.attrib_pointer("position", 2, 0, vertex);
+        rect_program.attrib_pointer("uvPosition", 2, 0, relative);
+        rect_program.uniformMatrix4f("MVP", matrix);
+        rect_program.uniform2f("half_size", w, h);
+        rect_program.uniform1f("radius", std::min({radius, w, h}));
+        rect_program.uniform4f("color", color);
+
+        GL_CALL(glEnable(GL_BLEND));
+        GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+        GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+        rect_program.deactivate();
+    }
+
+  private:
+    PangoContext *context;
+    std::unordered_map<PangoFont*, uint32_t> font_ids;
+    std::unordered_map<uint64_t, glyph_t> glyphs;
+    uint64_t generation = 0;
+
+    /* CPU copy of the atlas, one byte of coverage per pixel */
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(ATLAS_SIZE * ATLAS_SIZE);
+    /* Rows which have changed since the last upload */
+    int dirty_begin = 0, dirty_end = ATLAS_SIZE;
+
+    /* Glyphs are packed in rows (shelves) of increasing y */
+    int shelf_x = 0, shelf_y = 0, shelf_height = 0;
+
+    GLuint tex = -1;
+    OpenGL::program_t glyph_program, rect_program;
+
+    uint32_t get_font_id(PangoFont *font)
+    {
+        auto it = font_ids.find(font);
+        if (it != font_ids.end())
+        {
+            return it->second;
+        }
+
+        /* Keep the font alive, so that the pointer is not reused */
+        g_object_ref(font);
+        uint32_t id = font_ids.size();
+        font_ids[font] = id;
+        return id;
+    }
+
+    void clear_fonts()
+    {
+        for (auto& [font, _] : font_ids)
+        {
+            g_object_unref(font);
+        }
+
+        font_ids.clear();
+    }
+
+    void clear()
+    {
+        glyphs.clear();
+        clear_fonts();
+        std::fill(pixels.begin(), pixels.end(), 0);
+        shelf_x = shelf_y = shelf_height = 0;
+        dirty_begin = 0;
+        dirty_end   = ATLAS_SIZE;
+        ++generation;
+    }
+
+    /** Find space for a w x h rectangle, @return false if the atlas is full */
+    bool allocate(int w, int h, int& x, int& y)
+    {
+        if (shelf_x + w > ATLAS_SIZE)
+        {
+            shelf_x = 0;
+            shelf_y += shelf_height;
+            shelf_height = 0;
+        }
+
+        if (shelf_y + h > ATLAS_SIZE)
+        {
+            return false;
+        }
+
+        x = shelf_x;
+        y = shelf_y;
+        shelf_x += w;
+        shelf_height = std::max(shelf_height, h);
+        return true;
+    }
+
+    const glyph_t *rasterize(uint64_t key, PangoFont *font, PangoGlyph glyph)
+    {
+        PangoRectangle ink;
+        pango_font_get_glyph_extents(font, glyph, &ink, NULL);
+
+        /* One pixel of padding on each side, for linear filtering */
+        glyph_t result;
+        result.bearing_x = (int)std::floor((double)ink.x / PANGO_SCALE) - 1;
+        result.bearing_y = (int)std::floor((double)ink.y / PANGO_SCALE) - 1;
+        result.width  = (int)std::ceil((double)(ink.x + ink.width) / PANGO_SCALE) + 1 -
+            result.bearing_x;
+        result.height = (int)std::ceil((double)(ink.y + ink.height) / PANGO_SCALE) + 1 -
+            result.bearing_y;
+
+        if ((ink.width <= 0) || (ink.height <= 0) ||
+            (result.width > ATLAS_SIZE) || (result.height > ATLAS_SIZE))
+        {
+            /* Remember that there is nothing to draw */
+            glyphs[key] = glyph_t{0, 0, 0, 0, 0, 0};
+            return nullptr;
+        }
+
+        if (!allocate(result.width, result.height, result.x, result.y))
+        {
+            clear();
+            key = ((uint64_t)get_font_id(font) << 32) | glyph;
+            allocate(result.width, result.height, result.x, result.y);
+        }
+
+        auto surface = cairo_image_surface_create(CAIRO_FORMAT_A8,
+            result.width, result.height);
+        auto cr = cairo_create(surface);
+
+        PangoGlyphInfo info = {};
+        info.glyph = glyph;
+        PangoGlyphString glyph_string = {};
+        glyph_string.num_glyphs = 1;
+        glyph_string.glyphs     = &info;
+
+        cairo_set_source_rgba(cr, 1, 1, 1, 1);
+        cairo_move_to(cr, -result.bearing_x, -result.bearing_y);
+        pango_cairo_show_glyph_string(cr, font, &glyph_string);
+        cairo_destroy(cr);
+        cairo_surface_flush(surface);
+
+        auto src    = cairo_image_surface_get_data(surface);
+        int  stride = cairo_image_surface_get_stride(surface);
+        for (int row = 0; row < result.height; row++)
+        {
+            std::copy(src + row * stride, src + row * stride + result.width,
+                pixels.begin() + (result.y + row) * ATLAS_SIZE + result.x);
+        }
+
+        cairo_surface_destroy(surface);
+
+        dirty_begin = std::min(dirty_begin, result.y);
+        dirty_end   = std::max(dirty_end, result.y + result.height);
+        return &(glyphs[key] = result);
+    }
+
+    void ensure_gl_resources()
+    {
+        if (tex != (GLuint) - 1)
+        {
+            return;
+        }
+
+        static const char *vertex_source = R"(
+#version 100
+attribute mediump vec2 position;
+attribute mediump vec2 uvPosition;
+varying mediump vec2 uvpos;
+uniform mat4 MVP;
+
+void main() {
+    gl_Position = MVP * vec4(position, 0.0, 1.0);
+    uvpos = uvPosition;
+})";
+
+        static const char *glyph_source = R"(
+#version 100
+varying mediump vec2 uvpos;
+uniform sampler2D atlas;
+uniform mediump vec4 color;
+
+void main() {
+    gl_FragColor = color * texture2D(atlas, uvpos).a;
+})";
+
+        /* uvpos is the position relative to the center, in pixels */
+        static const char *rect_source = R"(
+#version 100
+varying mediump vec2 uvpos;
+uniform mediump vec2 half_size;
+uniform mediump float radius;
+uniform mediump vec4 color;
+
+void main() {
+    mediump vec2 q = abs(uvpos) - half_size + vec2(radius);
+    mediump float d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+    gl_FragColor = color * clamp(0.5 - d, 0.0, 1.0);
+})";
+
+        glyph_program.set_simple(OpenGL::compile_program(vertex_source, glyph_source));
+        rect_program.set_simple(OpenGL::compile_program(vertex_source, rect_source));
+
+        GL_CALL(glGenTextures(1, &tex));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_SIZE, ATLAS_SIZE, 0,
+            GL_ALPHA, GL_UNSIGNED_BYTE, NULL));
+
+        dirty_begin = 0;
+        dirty_end   = ATLAS_SIZE;
+    }
+
+    void upload()
+    {
+        if (dirty_begin >= dirty_end)
+        {
+            return;
+        }
+
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+        GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirty_begin, ATLAS_SIZE,
+            dirty_end - dirty_begin, GL_ALPHA, GL_UNSIGNED_BYTE,
+            pixels.data() + dirty_begin * ATLAS_SIZE));
+        GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+
+        dirty_begin = ATLAS_SIZE;
+        dirty_end   = 0;
+    }
+};
+
+/**
+ * A piece of text drawn from the shared glyph atlas.
+ *
+ * The text is shaped with Pango when it or the font changes. Changing the
+ * maximal size only clips the already shaped glyphs, and drawing is a single
+ * batch of quads. Compared to cairo_text_t, a changed title thus costs no
+ * rasterization and no texture upload, except for glyphs not seen before.
+ */
+class glyph_text_t
+{
+  public:
+    struct params
+    {
+        /* Pango font description, without the size */
+        std::string font = "sans-serif bold";
+        /* font size, in logical pixels */
+        double font_size = 12;
+        /* text color */
+        wf::color_t text_color = {1, 1, 1, 1};
+        /* color for background rectangle (only used if bg_rect == true) */
+        wf::color_t bg_color = {0, 0, 0, 0};
+        /* scale everything by this amount */
+        float output_scale = 1.f;
+        /* crop result to this size (if nonzero), in logical pixels */
+        wf::dimensions_t max_size{0, 0};
+        /* draw a rectangle in the background with bg_color */
+        bool bg_rect = false;
+        /* round the corners of the background rectangle */
+        bool rounded_rect = true;
+    };
+
+    glyph_text_t() = default;
+    ~glyph_text_t()
+    {
+        if (layout)
+        {
+            g_object_unref(layout);
+        }
+    }
+
+    glyph_text_t(const glyph_text_t&) = delete;
+    glyph_text_t(glyph_text_t&&) = delete;
+    glyph_text_t& operator =(const glyph_text_t&) = delete;
+    glyph_text_t& operator =(glyph_text_t&&) = delete;
+
+    /**
+     * Set the text to draw. This is cheap if neither the text nor the font
+     * have changed.
+     *
+     * @return The size needed to show the whole text, in pixels. If this is
+     *   larger than get_size(), the text was cropped to par.max_size.
+     */
+    wf::dimensions_t set_text(const std::string& text, const params& par)
+    {
+        bool reshape = !layout || (text != this->text) ||
+            (par.font != this->par.font) ||
+            (par.font_size != this->par.font_size) ||
+            (par.output_scale != this->par.output_scale);
+
+        this->text = text;
+        this->par  = par;
+        if (reshape)
+        {
+            shape();
+        }
+
+        /* The background padding is the same as the one of cairo_text_t */
+        auto old_pad = xpad + ypad;
+        xpad = par.bg_rect ? 10.0 * par.output_scale : 0.0;
+        ypad = par.bg_rect ? 0.2 * text_size.height : 0.0;
+        full_size = {
+            (int)(text_size.width + 2 * xpad),
+            (int)(text_size.height + 2 * ypad),
+        };
+
+        auto old_size = size;
+        size = full_size;
+        if (par.max_size.width && (size.width > par.max_size.width * par.output_scale))
+        {
+            size.width = (int)std::floor(par.max_size.width * par.output_scale);
+        }
+
+        if (par.max_size.height &&
+            (size.height > par.max_size.height * par.output_scale))
+        {
+            size.height = (int)std::floor(par.max_size.height * par.output_scale);
+        }
+
+        quads_valid &= !reshape && (size == old_size) && (xpad + ypad == old_pad);
+        return full_size;
+    }
+
+    /** @return The size of the drawn text, in pixels. */
+    wf::dimensions_t get_size() const
+    {
+        return size;
+    }
+
+    /**
+     * Draw the text with its top-left corner at @origin.
+     *
+     * Requires bound opengl context, the scissor box is not changed.
+     *
+     * @param origin Position in the coordinate system of fb.
+     * @param alpha Opacity multiplier for the text and the background.
+     */
+    void render(const wf::render_target_t& fb, wf::point_t origin, float alpha = 1.0)
+    {
+        if (!layout)
+        {
+            return;
+        }
+
+        auto matrix = fb.get_orthographic_projection();
+        float scale = par.output_scale;
+        if (par.bg_rect)
+        {
+            int min_r = (int)(20 * scale);
+            int r     = par.rounded_rect ?
+                (size.height > min_r ? min_r : (size.height - 2) / 2) : 0;
+            atlas->render_rounded_rectangle(matrix,
+                {origin.x, origin.y, (int)(size.width / scale), (int)(size.height / scale)},
+                scale, r, premultiply(par.bg_color, alpha));
+        }
+
+        if (!quads_valid || (quads_generation != atlas->get_generation()))
+        {
+            build_quads();
+        }
+
+        if (vertices.empty())
+        {
+            return;
+        }
+
+        std::vector<GLfloat> position(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i += 2)
+        {
+            position[i]     = origin.x + vertices[i] / scale;
+            position[i + 1] = origin.y + vertices[i + 1] / scale;
+        }
+
+        atlas->use_glyph_program(matrix, premultiply(par.text_color, alpha));
+        auto& program = atlas->get_glyph_program();
+        program.attrib_pointer("position", 2, 0, position.data());
+        program.attrib_pointer("uvPosition", 2, 0, uvs.data());
+
+        GL_CALL(glEnable(GL_BLEND));
+        GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+        GL_CALL(glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 2));
+        program.deactivate();
+    }
+
+  private:
+    wf::shared_data::ref_ptr_t<glyph_atlas_t> atlas;
+
+    std::string text;
+    params par;
+    PangoLayout *layout = nullptr;
+
+    /* A glyph of the shaped text, positioned relative to the layout origin */
+    struct positioned_glyph_t
+    {
+        PangoFont *font;
+        PangoGlyph glyph;
+        int x, y;
+    };
+
+    std::vector<positioned_glyph_t> shaped;
+    wf::dimensions_t text_size = {0, 0};
+    wf::dimensions_t full_size = {0, 0};
+    wf::dimensions_t size = {0, 0};
+    double xpad = 0, ypad = 0;
+
+    /* Quads of the visible glyphs, in pixels relative to the origin */
+    bool quads_valid = false;
+    uint64_t quads_generation = 0;
+    std::vector<GLfloat> vertices, uvs;
+
+    static glm::vec4 premultiply(const wf::color_t& c, float alpha)
+    {
+        float a = c.a * alpha;
+        return {c.r * a, c.g * a, c.b * a, a};
+    }
+
+    void shape()
+    {
+        if (layout)
+        {
+            g_object_unref(layout);
+        }
+
+        layout = pango_layout_new(atlas->get_context());
+        auto font_desc = pango_font_description_from_string(par.font.c_str());
+        pango_font_description_set_absolute_size(font_desc,
+            par.font_size * par.output_scale * PANGO_SCALE);
+        pango_layout_set_font_description(layout, font_desc);
+        pango_font_description_free(font_desc);
+        pango_layout_set_text(layout, text.c_str(), text.size());
+
+        PangoRectangle extents;
+        pango_layout_get_extents(layout, NULL, &extents);
+        text_size = {extents.width / PANGO_SCALE, extents.height / PANGO_SCALE};
+
+        shaped.clear();
+        auto iter = pango_layout_get_iter(layout);
+        do {
+            auto run = pango_layout_iter_get_run_readonly(iter);
+            if (!run)
+            {
+                continue;
+            }
+
+            PangoRectangle logical;
+            pango_layout_iter_get_run_extents(iter, NULL, &logical);
+            int baseline = pango_layout_iter_get_baseline(iter);
+            int x = logical.x - extents.x;
+
+            auto font = run->item->analysis.font;
+            for (int i = 0; i < run->glyphs->num_glyphs; i++)
+            {
+                auto& info = run->glyphs->glyphs[i];
+                if ((info.glyph != PANGO_GLYPH_EMPTY) &&
+                    !(info.glyph & PANGO_GLYPH_UNKNOWN_FLAG))
+                {
+                    shaped.push_back({font, info.glyph,
+                        (int)std::round((double)(x + info.geometry.x_offset) / PANGO_SCALE),
+                        (int)std::round((double)(baseline + info.geometry.y_offset) /
+                            PANGO_SCALE),
+                    });
+                }
+
+                x += info.geometry.width;
+            }
+        } while (pango_layout_iter_next_run(iter));
+
+        pango_layout_iter_free(iter);
+    }
+
+    void build_quads()
+    {
+        vertices.clear();
+        uvs.clear();
+
+        const float atlas_size = glyph_atlas_t::ATLAS_SIZE;
+        const float clip_x = size.width, clip_y = size.height;
+
+        /* Rasterizing a glyph may clear the atlas, invalidating the glyphs
+         * looked up before it. In that case, start over once. */
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            auto generation = atlas->get_generation();
+            vertices.clear();
+            uvs.clear();
+
+            for (auto& g : shaped)
+            {
+                auto glyph = atlas->get_glyph(g.font, g.glyph);
+                if (!glyph)
+                {
+                    continue;
+                }
+
+                float x1 = g.x + glyph->bearing_x + xpad;
+                float y1 = g.y + glyph->bearing_y + ypad;
+                float x2 = x1 + glyph->width;
+                float y2 = y1 + glyph->height;
+                float u1 = glyph->x, v1 = glyph->y;
+
+                /* Crop to the visible size */
+                float cx2 = std::min(x2, clip_x);
+                float cy2 = std::min(y2, clip_y);
+                if ((cx2 <= x1) || (cy2 <= y1))
+                {
+                    continue;
+                }
+
+                float u2 = u1 + (cx2 - x1);
+                float v2 = v1 + (cy2 - y1);
+                add_quad({x1, y1, cx2, cy2},
+                    {u1 / atlas_size, v1 / atlas_size, u2 / atlas_size, v2 / atlas_size});
+            }
+
+            if (generation == atlas->get_generation())
+            {
+                break;
+            }
+        }
+
+        quads_generation = atlas->get_generation();
+        quads_valid = true;
+    }
+
+    void add_quad(const gl_geometry& pos, const gl_geometry& uv)
+    {
+        vertices.insert(vertices.end(), {
+            pos.x1, pos.y1, pos.x2, pos.y1, pos.x2, pos.y2,
+            pos.x1, pos.y1, pos.x2, pos.y2, pos.x1, pos.y2,
+        });
+        uvs.insert(uvs.end(), {
+            uv.x1, uv.y1, uv.x2, uv.y1, uv.x2, uv.y2,
+            uv.x1, uv.y1, uv.x2, uv.y2, uv.x1, uv.y2,
+        });
+    }
+};
+}
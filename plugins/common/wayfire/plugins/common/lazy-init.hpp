@@ -0,0 +1,53 @@
+#pragma once
+
+#include <wayfire/option-wrapper.hpp>
+#include <functional>
+
+namespace wf
+{
+/**
+ * Runs the expensive part of a plugin's setup, for example shader
+ * compilation, either right away or, if core/lazy_plugin_init is enabled, on
+ * the first activation of the plugin.
+ *
+ * Meant for plugins whose only entry point is a binding. Such plugins should
+ * call ensure() at the start of each binding callback.
+ */
+class lazy_init_t
+{
+  public:
+    using setup_t = std::function<void ()>;
+
+    /** Set the setup function and run it unless lazy initialization is enabled. */
+    void set_setup(setup_t setup)
+    {
+        this->setup = setup;
+        this->done  = false;
+        if (!lazy)
+        {
+            ensure();
+        }
+    }
+
+    /** Run the setup function if it has not been run yet. */
+    void ensure()
+    {
+        if (!done && setup)
+        {
+            done = true;
+            setup();
+        }
+    }
+
+    /** @return Whether the setup function has been run. */
+    bool is_initialized() const
+    {
+        return done;
+    }
+
+  private:
+    wf::option_wrapper_t<bool> lazy{"core/lazy_plugin_init"};
+    setup_t setup;
+    bool done = false;
+};
+}
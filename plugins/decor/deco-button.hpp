@@ -6,7 +6,6 @@
 #include <wayfire/surface.hpp>
 #include <wayfire/render-manager.hpp>
 #include <wayfire/util/duration.hpp>
-#include <wayfire/plugins/common/simple-texture.hpp>
 
 #include <cairo.h>
 #include <pango/pango.h>
@@ -65,22 +64,21 @@ class button_t
     void set_pressed(bool is_pressed);
 
     /**
-     * Render the button on the given framebuffer at the given coordinates.
-     * Precondition: set_button_type() has been called, otherwise result is no-op
-     *
-     * @param buffer The target framebuffer
-     * @param geometry The geometry of the button, in logical coordinates
-     * @param scissor The scissor rectangle to render.
+     * @return The current hover progress of the button, in range [-1, 1].
+     * Negative values are used for the pressed state.
      */
-    void render(const wf::render_target_t& buffer, wf::geometry_t geometry,
-        wf::geometry_t scissor);
+    double get_hover_progress();
+
+    /**
+     * Notify the button that it has been rendered. Schedules another repaint
+     * while the hover animation is running.
+     */
+    void notify_rendered();
 
   private:
     const decoration_theme_t& theme;
 
-    /* Whether the button needs repaint */
     button_type_t type;
-    wf::simple_texture_t button_texture;
 
     /* Whether the button is currently being hovered */
     bool is_hovered = false;
@@ -93,11 +91,6 @@ class button_t
     wf::wl_idle_call idle_damage;
     /** Damage button the next time the main loop goes idle */
     void add_idle_damage();
-
-    /**
-     * Redraw the button surface and store it as a texture
-     */
-    void update_texture();
 };
 }
 }
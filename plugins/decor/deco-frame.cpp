@@ -0,0 +1,240 @@
+#include "deco-frame.hpp"
+#include <wayfire/plugins/common/cairo-util.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace wf
+{
+namespace decor
+{
+/* Frames cached before the cache is cleared, enough for both activation
+ * states on a few outputs with different scales. */
+static constexpr size_t MAX_CACHED_FRAMES = 8;
+
+static const char *frame_vertex_source = R"(
+#version 100
+attribute mediump vec2 position;
+attribute mediump vec2 uvPosition;
+varying mediump vec2 uvpos;
+uniform mat4 MVP;
+
+void main() {
+    gl_Position = MVP * vec4(position, 0.0, 1.0);
+    uvpos = uvPosition;
+})";
+
+static const char *frame_fragment_source = R"(
+#version 100
+varying mediump vec2 uvpos;
+uniform sampler2D frame;
+
+void main() {
+    gl_FragColor = texture2D(frame, uvpos);
+})";
+
+frame_cache_t::~frame_cache_t()
+{
+    frames.clear();
+    if (program_compiled)
+    {
+        OpenGL::render_begin();
+        program.free_resources();
+        OpenGL::render_end();
+    }
+}
+
+/**
+ * Render the frame texture for the given state.
+ */
+static void render_frame(const decoration_theme_t& theme, float scale,
+    bool active, frame_texture_t& frame)
+{
+    frame.border   = std::round(theme.get_border_size() * scale);
+    frame.titlebar = std::round(
+        (theme.get_title_height() + theme.get_border_size()) * scale);
+    frame.button_size = std::round(theme.get_title_height() * scale);
+
+    /* Buttons are padded by a pixel on each side, so that linear filtering
+     * does not bleed neighbouring cells in. */
+    const int pitch = frame.button_size + 2;
+    frame.buttons_y = frame.titlebar + frame.border + 2;
+    int width  = std::max(2 * frame.border + 1, frame_cache_t::HOVER_STEPS * pitch);
+    int height = frame.buttons_y + 3 * pitch;
+
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    auto cr = cairo_create(surface);
+
+    /* The nine-patch. The background is a single color for now, but the
+     * layout allows for rounded corners or gradients later. */
+    wf::color_t color = theme.get_background_color(active);
+    cairo_set_source_rgba(cr, color.r, color.g, color.b, color.a);
+    cairo_rectangle(cr, 0, 0, 2 * frame.border + 1, frame.titlebar + frame.border + 1);
+    cairo_fill(cr);
+
+    for (int type = BUTTON_CLOSE; type <= BUTTON_MINIMIZE; type++)
+    {
+        for (int step = 0; step < frame_cache_t::HOVER_STEPS; step++)
+        {
+            decoration_theme_t::button_state_t state = {
+                .width  = 1.0 * frame.button_size,
+                .height = 1.0 * frame.button_size,
+                .border = 1.0 * scale,
+                .hover_progress = -1.0 + 2.0 * step / (frame_cache_t::HOVER_STEPS - 1),
+            };
+
+            auto button = theme.get_button_surface((button_type_t)type, state);
+            cairo_set_source_surface(cr, button,
+                step * pitch + 1, frame.buttons_y + type * pitch + 1);
+            cairo_paint(cr);
+            cairo_surface_destroy(button);
+        }
+    }
+
+    cairo_destroy(cr);
+    cairo_surface_flush(surface);
+    cairo_surface_upload_to_texture(surface, frame.tex);
+    cairo_surface_destroy(surface);
+}
+
+const frame_texture_t& frame_cache_t::get(const decoration_theme_t& theme,
+    float scale, bool active)
+{
+    wf::color_t color = theme.get_background_color(active);
+    frame_key_t key{scale, active, theme.get_title_height(), theme.get_border_size(),
+        (float)color.r, (float)color.g, (float)color.b, (float)color.a};
+
+    auto it = frames.find(key);
+    if (it != frames.end())
+    {
+        return *it->second;
+    }
+
+    if (frames.size() >= MAX_CACHED_FRAMES)
+    {
+        /* We are inside a render pass already, so the textures are freed
+         * directly instead of with simple_texture_t::release(). */
+        for (auto& [_, frame] : frames)
+        {
+            GL_CALL(glDeleteTextures(1, &frame->tex.tex));
+            frame->tex.tex = -1;
+        }
+
+        frames.clear();
+    }
+
+    auto frame = std::make_unique<frame_texture_t>();
+    render_frame(theme, scale, active, *frame);
+    return *(frames[key] = std::move(frame));
+}
+
+OpenGL::program_t& frame_cache_t::use_program(const frame_texture_t& frame,
+    const glm::mat4& matrix)
+{
+    if (!program_compiled)
+    {
+        program.set_simple(OpenGL::compile_program(frame_vertex_source,
+            frame_fragment_source));
+        program_compiled = true;
+    }
+
+    program.use(wf::TEXTURE_TYPE_RGBA);
+    GL_CALL(glActiveTexture(GL_TEXTURE0));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, frame.tex.tex));
+    program.uniform1i("frame", 0);
+    program.uniformMatrix4f("MVP", matrix);
+    return program;
+}
+
+void frame_renderer_t::add_quad(const gl_geometry& pos, const gl_geometry& uv)
+{
+    vertices.insert(vertices.end(), {
+        pos.x1, pos.y1, pos.x2, pos.y1, pos.x2, pos.y2,
+        pos.x1, pos.y1, pos.x2, pos.y2, pos.x1, pos.y2,
+    });
+    uvs.insert(uvs.end(), {
+        uv.x1, uv.y1, uv.x2, uv.y1, uv.x2, uv.y2,
+        uv.x1, uv.y1, uv.x2, uv.y2, uv.x1, uv.y2,
+    });
+}
+
+void frame_renderer_t::begin(const decoration_theme_t& theme, float scale,
+    bool active, wf::geometry_t geometry)
+{
+    vertices.clear();
+    uvs.clear();
+    frame = &cache->get(theme, scale, active);
+
+    const float tw = frame->tex.width, th = frame->tex.height;
+    const float b  = theme.get_border_size();
+    const float t  = theme.get_title_height() + theme.get_border_size();
+
+    /* Positions of the patch edges, in logical pixels and texels. The middle
+     * patches sample the center of the stretched texel. */
+    const float x[] = {
+        (float)geometry.x, geometry.x + b,
+        geometry.x + geometry.width - b, (float)geometry.x + geometry.width,
+    };
+    const float y[] = {
+        (float)geometry.y, geometry.y + t,
+        geometry.y + geometry.height - b, (float)geometry.y + geometry.height,
+    };
+    const float u[] = {
+        0, (frame->border + 0.5f) / tw, (frame->border + 0.5f) / tw,
+        (2 * frame->border + 1) / tw,
+    };
+    const float v[] = {
+        0, (frame->titlebar + 0.5f) / th, (frame->titlebar + 0.5f) / th,
+        (frame->titlebar + frame->border + 1) / th,
+    };
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            /* The middle patch is covered by the view */
+            if ((i == 1) && (j == 1))
+            {
+                continue;
+            }
+
+            add_quad({x[j], y[i], x[j + 1], y[i + 1]},
+                {u[j], v[i], u[j + 1], v[i + 1]});
+        }
+    }
+}
+
+void frame_renderer_t::add_button(button_type_t type, double hover,
+    wf::geometry_t geometry)
+{
+    const float tw = frame->tex.width, th = frame->tex.height;
+    const int pitch = frame->button_size + 2;
+
+    int step = std::round((std::clamp(hover, -1.0, 1.0) + 1.0) / 2.0 *
+        (frame_cache_t::HOVER_STEPS - 1));
+    float u1 = step * pitch + 1;
+    float v1 = frame->buttons_y + (int)type * pitch + 1;
+
+    add_quad({(float)geometry.x, (float)geometry.y,
+        (float)geometry.x + geometry.width, (float)geometry.y + geometry.height},
+        {u1 / tw, v1 / th, (u1 + frame->button_size) / tw,
+            (v1 + frame->button_size) / th});
+}
+
+void frame_renderer_t::render(const wf::render_target_t& fb)
+{
+    if (!frame || vertices.empty())
+    {
+        return;
+    }
+
+    auto& program = cache->use_program(*frame, fb.get_orthographic_projection());
+    program.attrib_pointer("position", 2, 0, vertices.data());
+    program.attrib_pointer("uvPosition", 2, 0, uvs.data());
+
+    GL_CALL(glEnable(GL_BLEND));
+    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 2));
+    program.deactivate();
+}
+}
+}
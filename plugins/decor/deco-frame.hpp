@@ -0,0 +1,98 @@
+#pragma once
+#include <map>
+#include <tuple>
+#include <vector>
+#include <wayfire/opengl.hpp>
+#include <wayfire/plugins/common/simple-texture.hpp>
+#include <wayfire/plugins/common/shared-core-data.hpp>
+#include "deco-theme.hpp"
+
+namespace wf
+{
+namespace decor
+{
+/**
+ * The parts of the decoration which look the same for all views with the
+ * same theme, scale and activation state, rendered in a single texture.
+ *
+ * The texture contains the frame as a nine-patch (the corners and a single
+ * stretched row and column in the middle), followed by a grid of button
+ * icons, one row per button type and one column per hover step.
+ */
+struct frame_texture_t
+{
+    wf::simple_texture_t tex;
+    /* Size of the nine-patch corners, in pixels */
+    int border;
+    int titlebar;
+    /* Position of the first button cell and the size of a cell, in pixels */
+    int buttons_y;
+    int button_size;
+};
+
+/**
+ * A cache of frame textures, shared by all decorated views.
+ */
+class frame_cache_t
+{
+  public:
+    /** The number of hover states cached for each button. */
+    static constexpr int HOVER_STEPS = 21;
+
+    ~frame_cache_t();
+
+    /**
+     * Get the frame texture for the given state, rendering it if necessary.
+     * Requires bound opengl context.
+     */
+    const frame_texture_t& get(const decoration_theme_t& theme, float scale,
+        bool active);
+
+    /** Bind the program for drawing frame quads. Requires bound GL context. */
+    OpenGL::program_t& use_program(const frame_texture_t& frame,
+        const glm::mat4& matrix);
+
+  private:
+    using frame_key_t = std::tuple<float, bool, int, int, float, float, float, float>;
+    std::map<frame_key_t, std::unique_ptr<frame_texture_t>> frames;
+    OpenGL::program_t program;
+    bool program_compiled = false;
+};
+
+/**
+ * Collects the quads of a single decoration, so that the frame and all of
+ * its buttons are drawn with a single draw call.
+ */
+class frame_renderer_t
+{
+  public:
+    /**
+     * Start a new batch for a decoration.
+     *
+     * @param frame The geometry of the whole decoration, in logical pixels.
+     */
+    void begin(const decoration_theme_t& theme, float scale, bool active,
+        wf::geometry_t frame);
+
+    /**
+     * Add a button to the batch.
+     *
+     * @param hover The hover progress of the button, in range [-1, 1].
+     */
+    void add_button(button_type_t type, double hover, wf::geometry_t geometry);
+
+    /**
+     * Draw the batch. Requires bound opengl context and does not change the
+     * scissor box, so it can be called once per damaged rectangle.
+     */
+    void render(const wf::render_target_t& fb);
+
+  private:
+    wf::shared_data::ref_ptr_t<frame_cache_t> cache;
+    const frame_texture_t *frame = nullptr;
+    std::vector<GLfloat> vertices, uvs;
+
+    void add_quad(const gl_geometry& pos, const gl_geometry& uv);
+};
+}
+}
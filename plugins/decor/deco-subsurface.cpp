@@ -14,6 +14,7 @@
 #include "deco-subsurface.hpp"
 #include "deco-layout.hpp"
 #include "deco-theme.hpp"
+#include "deco-frame.hpp"
 
 #include <wayfire/plugins/common/cairo-util.hpp>
 
@@ -33,28 +34,8 @@ class simple_decoration_surface : public wf::surface_interface_t,
         }
     };
 
-    void update_title(int width, int height, double scale)
-    {
-        int target_width  = width * scale;
-        int target_height = height * scale;
-
-        if ((title_texture.tex.width != target_width) ||
-            (title_texture.tex.height != target_height) ||
-            (title_texture.current_text != view->get_title()))
-        {
-            auto surface = theme.render_text(view->get_title(),
-                target_width, target_height);
-            cairo_surface_upload_to_texture(surface, title_texture.tex);
-            cairo_surface_destroy(surface);
-            title_texture.current_text = view->get_title();
-        }
-    }
-
-    struct
-    {
-        wf::simple_texture_t tex;
-        std::string current_text = "";
-    } title_texture;
+    wf::glyph_text_t title_text;
+    wf::decor::frame_renderer_t frame_renderer;
 
     wf::decor::decoration_theme_t theme;
     wf::decor::decoration_layout_t layout;
@@ -102,46 +83,53 @@ class simple_decoration_surface : public wf::surface_interface_t,
     void render_title(const wf::render_target_t& fb,
         wf::geometry_t geometry)
     {
-        update_title(geometry.width, geometry.height, fb.scale);
-        OpenGL::render_texture(title_texture.tex.tex, fb, geometry,
-            glm::vec4(1.0f), OpenGL::TEXTURE_TRANSFORM_INVERT_Y);
+        theme.render_title(fb, geometry, view->get_title(), title_text);
     }
 
-    void render_scissor_box(const wf::render_target_t& fb, wf::point_t origin,
-        const wlr_box& scissor)
+    virtual void simple_render(const wf::render_target_t& fb, int x, int y,
+        const wf::region_t& damage) override
     {
-        /* Clear background */
-        wlr_box geometry{origin.x, origin.y, size.width, size.height};
-        theme.render_background(fb, geometry, scissor, view->activated);
+        wf::region_t frame = this->cached_region + wf::point_t{x, y};
+        frame &= damage;
+        if (frame.empty())
+        {
+            return;
+        }
+
+        OpenGL::render_begin(fb);
 
-        /* Draw title & buttons */
-        auto renderables = layout.get_renderable_areas();
-        for (auto item : renderables)
+        /* The frame and the buttons come from a texture shared by all views,
+         * so they are drawn with a single batch of quads. */
+        wf::point_t origin{x, y};
+        frame_renderer.begin(theme, fb.scale, view->activated,
+            {x, y, size.width, size.height});
+
+        nonstd::observer_ptr<wf::decor::decoration_area_t> title;
+        for (auto item : layout.get_renderable_areas())
         {
             if (item->get_type() == wf::decor::DECORATION_AREA_TITLE)
             {
-                OpenGL::render_begin(fb);
-                fb.logic_scissor(scissor);
-                render_title(fb, item->get_geometry() + origin);
-                OpenGL::render_end();
+                title = item;
             } else // button
             {
-                item->as_button().render(fb,
-                    item->get_geometry() + origin, scissor);
+                auto& button = item->as_button();
+                frame_renderer.add_button(button.get_button_type(),
+                    button.get_hover_progress(), item->get_geometry() + origin);
+                button.notify_rendered();
             }
         }
-    }
-
-    virtual void simple_render(const wf::render_target_t& fb, int x, int y,
-        const wf::region_t& damage) override
-    {
-        wf::region_t frame = this->cached_region + wf::point_t{x, y};
-        frame &= damage;
 
         for (const auto& box : frame)
         {
-            render_scissor_box(fb, {x, y}, wlr_box_from_pixman_box(box));
+            fb.logic_scissor(wlr_box_from_pixman_box(box));
+            frame_renderer.render(fb);
+            if (title)
+            {
+                render_title(fb, title->get_geometry() + origin);
+            }
         }
+
+        OpenGL::render_end();
     }
 
     bool accepts_input(int32_t sx, int32_t sy) override
@@ -25,60 +25,36 @@ int decoration_theme_t::get_border_size() const
 }
 
 /**
- * Fill the given rectangle with the background color(s).
- *
- * @param fb The target framebuffer, must have been bound already
- * @param rectangle The rectangle to redraw.
- * @param scissor The GL scissor rectangle to use.
+ * @return The background color of the frame.
  * @param active Whether to use active or inactive colors
  */
-void decoration_theme_t::render_background(const wf::render_target_t& fb,
-    wf::geometry_t rectangle, const wf::geometry_t& scissor, bool active) const
+wf::color_t decoration_theme_t::get_background_color(bool active) const
 {
-    wf::color_t color = active ? active_color : inactive_color;
-    OpenGL::render_begin(fb);
-    fb.logic_scissor(scissor);
-    OpenGL::render_rectangle(rectangle, color, fb.get_orthographic_projection());
-    OpenGL::render_end();
+    return active ? active_color : inactive_color;
 }
 
 /**
- * Render the given text on a cairo_surface_t with the given size.
- * The caller is responsible for freeing the memory afterwards.
+ * Render the title text in the given rectangle, cropping it if necessary.
  */
-cairo_surface_t*decoration_theme_t::render_text(std::string text,
-    int width, int height) const
+void decoration_theme_t::render_title(const wf::render_target_t& fb,
+    wf::geometry_t rectangle, const std::string& title, wf::glyph_text_t& text) const
 {
-    const auto format = CAIRO_FORMAT_ARGB32;
-    auto surface = cairo_image_surface_create(format, width, height);
-
-    if (height == 0)
+    if (rectangle.height <= 0)
     {
-        return surface;
+        return;
     }
 
-    auto cr = cairo_create(surface);
-
     const float font_scale = 0.8;
-    const float font_size  = height * font_scale;
-
-    PangoFontDescription *font_desc;
-    PangoLayout *layout;
-
-    // render text
-    font_desc = pango_font_description_from_string(((std::string)font).c_str());
-    pango_font_description_set_absolute_size(font_desc, font_size * PANGO_SCALE);
-
-    layout = pango_cairo_create_layout(cr);
-    pango_layout_set_font_description(layout, font_desc);
-    pango_layout_set_text(layout, text.c_str(), text.size());
-    cairo_set_source_rgba(cr, 1, 1, 1, 1);
-    pango_cairo_show_layout(cr, layout);
-    pango_font_description_free(font_desc);
-    g_object_unref(layout);
-    cairo_destroy(cr);
 
-    return surface;
+    wf::glyph_text_t::params par;
+    par.font = (std::string)font;
+    par.font_size    = rectangle.height * font_scale;
+    par.text_color   = {1, 1, 1, 1};
+    par.output_scale = fb.scale;
+    par.max_size     = wf::dimensions(rectangle);
+
+    text.set_text(title, par);
+    text.render(fb, {rectangle.x, rectangle.y});
 }
 
 cairo_surface_t*decoration_theme_t::get_button_surface(button_type_t button,
@@ -1,6 +1,7 @@
 #pragma once
 #include <wayfire/render-manager.hpp>
 #include "deco-button.hpp"
+#include <wayfire/plugins/common/glyph-text.hpp>
 
 namespace wf
 {
@@ -22,21 +23,21 @@ class decoration_theme_t
     int get_border_size() const;
 
     /**
-     * Fill the given rectangle with the background color(s).
-     *
-     * @param fb The target framebuffer, must have been bound already.
-     * @param rectangle The rectangle to redraw.
-     * @param scissor The GL scissor rectangle to use.
+     * @return The background color of the frame.
      * @param active Whether to use active or inactive colors
      */
-    void render_background(const wf::render_target_t& fb, wf::geometry_t rectangle,
-        const wf::geometry_t& scissor, bool active) const;
+    wf::color_t get_background_color(bool active) const;
 
     /**
-     * Render the given text on a cairo_surface_t with the given size.
-     * The caller is responsible for freeing the memory afterwards.
+     * Render the title text in the given rectangle, cropping it if necessary.
+     *
+     * @param fb The target framebuffer, must have been bound already.
+     * @param rectangle The title area.
+     * @param title The text to render.
+     * @param text The glyph text which caches the shaped title between frames.
      */
-    cairo_surface_t *render_text(std::string text, int width, int height) const;
+    void render_title(const wf::render_target_t& fb, wf::geometry_t rectangle,
+        const std::string& title, wf::glyph_text_t& text) const;
 
     struct button_state_t
     {
@@ -13,6 +13,7 @@
 #include <wayfire/nonstd/wlroots.hpp>
 #include <wayfire/plugins/common/geometry-animation.hpp>
 #include <wayfire/render-manager.hpp>
+#include <wayfire/animation-scheduler.hpp>
 #include <wayfire/plugins/wobbly/wobbly-signal.hpp>
 
 namespace wf
@@ -185,7 +186,9 @@ class grid_animation_t : public wf::custom_data_t
         this->type   = type;
         this->animation = wf::geometry_animation_t{duration};
 
-        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        wf::animation_scheduler_t::get(output).add(this,
+            "grid/crossfade:" + std::to_string(view->get_id()),
+            [=] () { return step(); });
         output->connect_signal("view-disappeared", &unmapped);
     }
 
@@ -243,7 +246,7 @@ class grid_animation_t : public wf::custom_data_t
     ~grid_animation_t()
     {
         view->get_transformed_node()->rem_transformer<crossfade_node_t>();
-        output->render->rem_effect(&pre_hook);
+        wf::animation_scheduler_t::get(output).remove(this);
     }
 
     grid_animation_t(const grid_animation_t &) = delete;
@@ -252,11 +255,13 @@ class grid_animation_t : public wf::custom_data_t
     grid_animation_t& operator =(grid_animation_t&&) = delete;
 
   protected:
-    wf::effect_hook_t pre_hook = [=] ()
+    bool step()
     {
         if (!animation.running())
         {
-            return destroy();
+            /* Removes the animation from the scheduler */
+            destroy();
+            return false;
         }
 
         if (view->get_wm_geometry() != original)
@@ -280,7 +285,8 @@ class grid_animation_t : public wf::custom_data_t
 
         tr->overlay_alpha = animation.progress();
         view->damage();
-    };
+        return true;
+    }
 
     void destroy()
     {
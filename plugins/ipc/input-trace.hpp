@@ -0,0 +1,340 @@
+#pragma once
+
+#include <wayfire/core.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace wf
+{
+namespace input_trace
+{
+/**
+ * Input traces are binary files with a header followed by fixed-size event
+ * records in native byte order. They are meant to be replayed on the same
+ * machine (or at least the same architecture) they were recorded on.
+ */
+static constexpr char TRACE_MAGIC[4] = {'W', 'F', 'I', 'T'};
+static constexpr uint32_t TRACE_VERSION = 1;
+
+enum event_type_t : uint32_t
+{
+    KEY                    = 1,
+    POINTER_MOTION         = 2,
+    POINTER_MOTION_ABSOLUTE = 3,
+    POINTER_BUTTON         = 4,
+    POINTER_AXIS           = 5,
+    TOUCH_DOWN             = 6,
+    TOUCH_MOTION           = 7,
+    TOUCH_UP               = 8,
+};
+
+struct event_t
+{
+    /** Time since the start of the recording */
+    uint64_t time_us;
+    event_type_t type;
+    /** Keycode, button, touch id or axis orientation */
+    uint32_t code;
+    /** Key/button state or axis source */
+    uint32_t state;
+    /** Discrete axis steps */
+    int32_t discrete;
+    /**
+     * Relative motion, absolute position in [0, 1] (pointer and touch), or the
+     * axis delta in x.
+     */
+    double x, y;
+};
+
+static_assert(sizeof(event_t) == 40, "Trace records must have a fixed size");
+
+/**
+ * Records all events from input devices, as seen by core before any
+ * processing, into a trace file.
+ */
+class recorder_t
+{
+  public:
+    /** @return false if the file could not be opened. */
+    bool start(const std::string& path)
+    {
+        stop();
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            return false;
+        }
+
+        file.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        file.write((const char*)&TRACE_VERSION, sizeof(TRACE_VERSION));
+
+        recorded = 0;
+        start_time = std::chrono::steady_clock::now();
+        auto& core = wf::get_core();
+        core.connect_signal("keyboard_key", &on_key);
+        core.connect_signal("pointer_motion", &on_motion);
+        core.connect_signal("pointer_motion_absolute", &on_motion_absolute);
+        core.connect_signal("pointer_button", &on_button);
+        core.connect_signal("pointer_axis", &on_axis);
+        core.connect_signal("touch_down", &on_touch_down);
+        core.connect_signal("touch_motion", &on_touch_motion);
+        core.connect_signal("touch_up", &on_touch_up);
+        return true;
+    }
+
+    /** Stop recording and close the file. @return The number of events. */
+    uint64_t stop()
+    {
+        on_key.disconnect();
+        on_motion.disconnect();
+        on_motion_absolute.disconnect();
+        on_button.disconnect();
+        on_axis.disconnect();
+        on_touch_down.disconnect();
+        on_touch_motion.disconnect();
+        on_touch_up.disconnect();
+        if (file.is_open())
+        {
+            file.close();
+        }
+
+        return recorded;
+    }
+
+    bool is_recording() const
+    {
+        return file.is_open();
+    }
+
+    ~recorder_t()
+    {
+        stop();
+    }
+
+  private:
+    std::ofstream file;
+    uint64_t recorded = 0;
+    std::chrono::steady_clock::time_point start_time;
+
+    void record(event_t ev)
+    {
+        ev.time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+        file.write((const char*)&ev, sizeof(ev));
+        ++recorded;
+    }
+
+    template<class T>
+    static T *get_event(wf::signal_data_t *data)
+    {
+        return static_cast<wf::input_event_signal<T>*>(data)->event;
+    }
+
+    wf::signal_connection_t on_key = [=] (wf::signal_data_t *data)
+    {
+        auto ev = get_event<wlr_keyboard_key_event>(data);
+        record({0, KEY, ev->keycode, (uint32_t)ev->state, 0, 0, 0});
+    };
+
+    wf::signal_connection_t on_motion = [=] (wf::signal_data_t *data)
+    {
+        auto ev = get_event<wlr_pointer_motion_event>(data);
+        record({0, POINTER_MOTION, 0, 0, 0, ev->delta_x, ev->delta_y});
+    };
+
+    wf::signal_connection_t on_motion_absolute = [=] (wf::signal_data_t *data)
+    {
+        auto ev = get_event<wlr_pointer_motion_absolute_event>(data);
+        record({0, POINTER_MOTION_ABSOLUTE, 0, 0, 0, ev->x, ev->y});
+    };
+
+    wf::signal_connection_t on_button = [=] (wf::signal_data_t *data)
+    {
+        auto ev = get_event<wlr_pointer_button_event>(data);
+        record({0, POINTER_BUTTON, ev->button, (uint32_t)ev->state, 0, 0, 0});
+    };
+
+    wf::signal_connection_t on_axis = [=] (wf::signal_data_t *data)
+    {
+        auto ev = get_event<wlr_pointer_axis_event>(data);
+        record({0, POINTER_AXIS, (uint32_t)ev->orientation, (uint32_t)ev->source,
+            ev->delta_discrete, ev->delta, 0});
+    };
+
+    wf::signal_connection_t on_touch_down = [=] (wf::signal_data_t *data)
+    {
+        auto ev = get_event<wlr_touch_down_event>(data);
+        record({0, TOUCH_DOWN, (uint32_t)ev->touch_id, 0, 0, ev->x, ev->y});
+    };
+
+    wf::signal_connection_t on_touch_motion = [=] (wf::signal_data_t *data)
+    {
+        auto ev = get_event<wlr_touch_motion_event>(data);
+        record({0, TOUCH_MOTION, (uint32_t)ev->touch_id, 0, 0, ev->x, ev->y});
+    };
+
+    wf::signal_connection_t on_touch_up = [=] (wf::signal_data_t *data)
+    {
+        auto ev = get_event<wlr_touch_up_event>(data);
+        record({0, TOUCH_UP, (uint32_t)ev->touch_id, 0, 0, 0, 0});
+    };
+};
+
+/**
+ * Load a trace file.
+ * @return false if the file cannot be read or is not a valid trace.
+ */
+inline bool load_trace(const std::string& path, std::vector<event_t>& events)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(TRACE_MAGIC)];
+    uint32_t version;
+    if (!file.read(magic, sizeof(magic)) ||
+        !file.read((char*)&version, sizeof(version)) ||
+        std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) || (version != TRACE_VERSION))
+    {
+        return false;
+    }
+
+    event_t ev;
+    events.clear();
+    while (file.read((char*)&ev, sizeof(ev)))
+    {
+        events.push_back(ev);
+    }
+
+    return true;
+}
+
+/**
+ * Feeds a trace back to the compositor, measuring how long the processing
+ * of each event takes.
+ */
+class replayer_t
+{
+  public:
+    /** Feed a single event to the compositor. Must process it synchronously. */
+    using feed_callback_t = std::function<void (const event_t&)>;
+
+    /** Events processed in one go when replaying without delays. */
+    static constexpr size_t MAX_BATCH = 64;
+
+    /**
+     * Start replaying.
+     *
+     * @param speed The speed factor relative to the recording. 0 means that the
+     *   events are replayed as fast as possible, while still letting the event
+     *   loop run between batches of events.
+     */
+    void start(std::vector<event_t> trace, double speed, feed_callback_t feed)
+    {
+        stop();
+        this->events = std::move(trace);
+        this->speed  = speed;
+        this->feed   = feed;
+        this->next   = 0;
+        this->latencies_us.clear();
+        this->latencies_us.reserve(events.size());
+        this->start_time = std::chrono::steady_clock::now();
+        schedule_next();
+    }
+
+    void stop()
+    {
+        timer.disconnect();
+        idle.disconnect();
+    }
+
+    bool is_running() const
+    {
+        return next < events.size();
+    }
+
+    size_t get_processed() const
+    {
+        return next;
+    }
+
+    size_t get_total() const
+    {
+        return events.size();
+    }
+
+    /** @return Processing latency of each replayed event so far, in us. */
+    const std::vector<double>& get_latencies() const
+    {
+        return latencies_us;
+    }
+
+  private:
+    std::vector<event_t> events;
+    std::vector<double> latencies_us;
+    double speed = 1.0;
+    size_t next  = 0;
+    feed_callback_t feed;
+    std::chrono::steady_clock::time_point start_time;
+
+    wf::wl_timer timer;
+    wf::wl_idle_call idle;
+
+    /** @return Time until the next event is due, in us. */
+    int64_t time_until_next()
+    {
+        if (speed <= 0)
+        {
+            return 0;
+        }
+
+        auto now = std::chrono::steady_clock::now() - start_time;
+        int64_t due = events[next].time_us / speed;
+        return due - std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+    }
+
+    void schedule_next()
+    {
+        if (!is_running())
+        {
+            return;
+        }
+
+        int64_t wait_us = time_until_next();
+        if (wait_us < 1000)
+        {
+            idle.run_once([=] () { replay_due_events(); });
+        } else
+        {
+            timer.set_timeout(wait_us / 1000, [=] ()
+            {
+                replay_due_events();
+                return false;
+            });
+        }
+    }
+
+    void replay_due_events()
+    {
+        size_t batch = 0;
+        while (is_running() && (time_until_next() < 1000) && (batch < MAX_BATCH))
+        {
+            auto begin = std::chrono::steady_clock::now();
+            feed(events[next++]);
+            std::chrono::duration<double, std::micro> took =
+                std::chrono::steady_clock::now() - begin;
+            latencies_us.push_back(took.count());
+            ++batch;
+        }
+
+        schedule_next();
+    }
+};
+}
+}
@@ -0,0 +1,267 @@
+/**
+ * A small client which measures the round-trip latency and throughput of the
+ * IPC socket for each of the supported encodings.
+ *
+ * Usage: ipc-benchmark [-n iterations] [-m method] [-d data-json]
+ * The socket is taken from $WAYFIRE_SOCKET.
+ */
+#include "ipc-encoding.hpp"
+#include "bench-util.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using wf::ipc::encoding_t;
+
+/** Number of requests sent at once in the throughput test. */
+static constexpr int PIPELINE_DEPTH = 64;
+
+static int connect_to(const char *path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+    {
+        return -1;
+    }
+
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool write_all(int fd, const char *buf, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t w = write(fd, buf, n);
+        if (w <= 0)
+        {
+            return false;
+        }
+
+        buf += w;
+        n   -= w;
+    }
+
+    return true;
+}
+
+static bool read_all(int fd, char *buf, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t r = read(fd, buf, n);
+        if (r <= 0)
+        {
+            return false;
+        }
+
+        buf += r;
+        n   -= r;
+    }
+
+    return true;
+}
+
+static std::string frame(const nlohmann::json& message, encoding_t encoding)
+{
+    std::string out(4, '\0');
+    wf::ipc::encode_message(message, encoding, out);
+    uint32_t len = out.length() - 4;
+    std::memcpy(out.data(), &len, 4);
+    return out;
+}
+
+static nlohmann::json receive(int fd, encoding_t encoding)
+{
+    uint32_t len;
+    if (!read_all(fd, (char*)&len, 4))
+    {
+        return nlohmann::json(nlohmann::json::value_t::discarded);
+    }
+
+    std::vector<char> buf(len);
+    if (!read_all(fd, buf.data(), len))
+    {
+        return nlohmann::json(nlohmann::json::value_t::discarded);
+    }
+
+    return wf::ipc::decode_message(buf.data(), len, encoding);
+}
+
+struct result_t
+{
+    double avg_us = 0, p50_us = 0, p99_us = 0;
+    double msgs_per_sec = 0;
+};
+
+static bool run_benchmark(const char *socket_path, const std::string& name,
+    encoding_t encoding, const nlohmann::json& request, int iterations, result_t& result)
+{
+    int fd = connect_to(socket_path);
+    if (fd == -1)
+    {
+        std::cerr << "Failed to connect to " << socket_path << std::endl;
+        return false;
+    }
+
+    // The encoding switch request itself is always sent as JSON
+    auto msg = frame({{"method", "core/set_encoding"}, {"data", {{"encoding", name}}}},
+        encoding_t::JSON);
+    if (!write_all(fd, msg.data(), msg.size()) ||
+        receive(fd, encoding_t::JSON).count("error"))
+    {
+        std::cerr << "Server does not support encoding " << name << std::endl;
+        close(fd);
+        return false;
+    }
+
+    // Latency: one request at a time
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = wf::bench::clock::now();
+        msg = frame(request, encoding);
+        if (!write_all(fd, msg.data(), msg.size()) || receive(fd, encoding).is_discarded())
+        {
+            std::cerr << "Connection error" << std::endl;
+            close(fd);
+            return false;
+        }
+
+        samples.push_back(wf::bench::elapsed_us(start));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (auto& s : samples)
+    {
+        sum += s;
+    }
+
+    result.avg_us = sum / iterations;
+    result.p50_us = samples[iterations / 2];
+    result.p99_us = samples[std::min(iterations - 1, iterations * 99 / 100)];
+
+    // Throughput: pipeline the requests in batches, so that neither side's
+    // buffers fill up while the other is still writing.
+    const std::string framed = frame(request, encoding);
+    auto start = wf::bench::clock::now();
+    for (int sent = 0; sent < iterations; sent += PIPELINE_DEPTH)
+    {
+        int batch_size = std::min(PIPELINE_DEPTH, iterations - sent);
+        std::string batch;
+        for (int i = 0; i < batch_size; i++)
+        {
+            batch += framed;
+        }
+
+        if (!write_all(fd, batch.data(), batch.size()))
+        {
+            std::cerr << "Connection error" << std::endl;
+            close(fd);
+            return false;
+        }
+
+        for (int i = 0; i < batch_size; i++)
+        {
+            if (receive(fd, encoding).is_discarded())
+            {
+                std::cerr << "Connection error" << std::endl;
+                close(fd);
+                return false;
+            }
+        }
+    }
+
+    result.msgs_per_sec = iterations / (wf::bench::elapsed_us(start) / 1e6);
+
+    close(fd);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations     = 10000;
+    std::string method = "core/ping";
+    nlohmann::json data = nlohmann::json::object();
+
+    int c;
+    while ((c = getopt(argc, argv, "n:m:d:h")) != -1)
+    {
+        switch (c)
+        {
+          case 'n':
+            iterations = std::max(1, atoi(optarg));
+            break;
+
+          case 'm':
+            method = optarg;
+            break;
+
+          case 'd':
+            data = nlohmann::json::parse(optarg, nullptr, false);
+            if (data.is_discarded())
+            {
+                std::cerr << "Invalid JSON data: " << optarg << std::endl;
+                return 1;
+            }
+
+            break;
+
+          default:
+            std::cout << "Usage: " << argv[0] <<
+                " [-n iterations] [-m method] [-d data-json]" << std::endl;
+            return c == 'h' ? 0 : 1;
+        }
+    }
+
+    const char *socket_path = getenv("WAYFIRE_SOCKET");
+    if (!socket_path)
+    {
+        std::cerr << "WAYFIRE_SOCKET is not set" << std::endl;
+        return 1;
+    }
+
+    nlohmann::json request = {{"method", method}, {"data", data}};
+    std::cout << "method " << method << ", " << iterations << " iterations" << std::endl;
+    std::cout << "encoding    avg(us)    p50(us)    p99(us)    msgs/s" << std::endl;
+
+    const std::pair<std::string, encoding_t> encodings[] = {
+        {"json", encoding_t::JSON},
+        {"cbor", encoding_t::CBOR},
+        {"msgpack", encoding_t::MSGPACK},
+    };
+
+    for (auto& [name, encoding] : encodings)
+    {
+        result_t r;
+        if (!run_benchmark(socket_path, name, encoding, request, iterations, r))
+        {
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(8) << name << std::right <<
+            std::fixed << std::setprecision(2) << " " << std::setw(10) << r.avg_us <<
+            " " << std::setw(10) << r.p50_us << " " << std::setw(10) << r.p99_us <<
+            std::setprecision(0) << " " << std::setw(10) << r.msgs_per_sec << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+
+namespace wf
+{
+namespace ipc
+{
+/**
+ * The format used for the messages on a connection. All formats carry the
+ * same messages, binary formats just avoid the cost of printing and parsing
+ * JSON text. A connection starts with JSON and may switch with
+ * core/set_encoding.
+ */
+enum class encoding_t
+{
+    JSON,
+    CBOR,
+    MSGPACK,
+};
+
+inline std::optional<encoding_t> encoding_from_string(const std::string& name)
+{
+    if (name == "json")
+    {
+        return encoding_t::JSON;
+    } else if (name == "cbor")
+    {
+        return encoding_t::CBOR;
+    } else if (name == "msgpack")
+    {
+        return encoding_t::MSGPACK;
+    }
+
+    return {};
+}
+
+/** Serialize a message, appending it to the given buffer. */
+inline void encode_message(const nlohmann::json& message, encoding_t encoding,
+    std::string& out)
+{
+    switch (encoding)
+    {
+      case encoding_t::JSON:
+        out += message.dump();
+        break;
+
+      case encoding_t::CBOR:
+        nlohmann::json::to_cbor(message, out);
+        break;
+
+      case encoding_t::MSGPACK:
+        nlohmann::json::to_msgpack(message, out);
+        break;
+    }
+}
+
+/**
+ * Parse a message. The returned value is discarded (is_discarded() is true)
+ * if the data is not valid in the given encoding.
+ */
+inline nlohmann::json decode_message(const char *data, size_t len,
+    encoding_t encoding)
+{
+    switch (encoding)
+    {
+      case encoding_t::JSON:
+        return nlohmann::json::parse(data, data + len, nullptr, false);
+
+      case encoding_t::CBOR:
+        return nlohmann::json::from_cbor(data, data + len, true, false);
+
+      case encoding_t::MSGPACK:
+        return nlohmann::json::from_msgpack(data, data + len, true, false);
+    }
+
+    return nlohmann::json(nlohmann::json::value_t::discarded);
+}
+}
+}
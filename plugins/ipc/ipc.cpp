@@ -2,9 +2,10 @@
 #include <wayfire/util/log.hpp>
 #include <wayfire/core.hpp>
 
+#include <cstring>
 #include <fcntl.h>
 #include <sys/socket.h>
-#include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 /**
@@ -20,6 +21,23 @@ int wl_loop_handle_ipc_fd_connection(int, uint32_t, void *data)
 
 wf::ipc::server_t::server_t(std::string socket_path)
 {
+    register_client_method("core/set_encoding", [] (nlohmann::json data, client_t *client)
+    {
+        if (!data.count("encoding") || !data["encoding"].is_string())
+        {
+            return nlohmann::json{{"error", "Missing or wrong json type for `encoding`!"}};
+        }
+
+        auto encoding = encoding_from_string(data["encoding"]);
+        if (!encoding)
+        {
+            return nlohmann::json{{"error", "Unsupported encoding " + data["encoding"].dump()}};
+        }
+
+        client->set_encoding(*encoding);
+        return nlohmann::json{{"result", "ok"}};
+    });
+
     this->fd = setup_socket(socket_path.c_str());
     if (fd == -1)
     {
@@ -42,6 +60,15 @@ wf::ipc::server_t::~server_t()
 
 void wf::ipc::server_t::register_method(
     std::string method, method_cb handler)
+{
+    this->methods[method] = [handler] (nlohmann::json data, client_t*)
+    {
+        return handler(std::move(data));
+    };
+}
+
+void wf::ipc::server_t::register_client_method(
+    std::string method, client_method_cb handler)
 {
     this->methods[method] = handler;
 }
@@ -52,11 +79,11 @@ void wf::ipc::server_t::unregister_method(std::string method)
 }
 
 nlohmann::json wf::ipc::server_t::call_method(std::string method,
-    nlohmann::json data)
+    nlohmann::json data, client_t *client)
 {
     if (this->methods.count(method))
     {
-        return this->methods[method](std::move(data));
+        return this->methods[method](std::move(data), client);
     }
 
     return {
@@ -64,6 +91,31 @@ nlohmann::json wf::ipc::server_t::call_method(std::string method,
     };
 }
 
+bool wf::ipc::server_t::has_subscribers(const std::string& event) const
+{
+    return std::any_of(clients.begin(), clients.end(), [&] (const auto& cl)
+    {
+        return cl->is_subscribed(event);
+    });
+}
+
+void wf::ipc::server_t::send_event(const std::string& event,
+    const std::string& key, nlohmann::json data)
+{
+    static uint64_t event_serial = 0;
+
+    data["event"] = event;
+    const std::string full_key = event + "/" +
+        (key.empty() ? "#" + std::to_string(++event_serial) : key);
+    for (auto& client : clients)
+    {
+        if (client->is_subscribed(event))
+        {
+            client->queue_event(full_key, data);
+        }
+    }
+}
+
 int wf::ipc::server_t::setup_socket(const char *address)
 {
     int fd = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -137,6 +189,16 @@ void wf::ipc::server_t::client_disappeared(client_t *client)
     clients.erase(it, clients.end());
 }
 
+void wf::ipc::server_t::schedule_cleanup()
+{
+    idle_cleanup.run_once([=] ()
+    {
+        auto it = std::remove_if(clients.begin(), clients.end(),
+            [&] (const auto& cl) { return cl->is_closing(); });
+        clients.erase(it, clients.end());
+    });
+}
+
 /* --------------------------- Per-client code ------------------------------*/
 
 int wl_loop_handle_ipc_client_fd_event(int, uint32_t mask, void *data)
@@ -149,6 +211,20 @@ int wl_loop_handle_ipc_client_fd_event(int, uint32_t mask, void *data)
 static constexpr int MAX_MESSAGE_LEN = (1 << 20);
 static constexpr int HEADER_LEN = 4;
 
+/**
+ * When this many bytes are waiting to be sent to the client, we stop handling
+ * new requests from it until the queue has been drained.
+ */
+static constexpr size_t OUTPUT_QUEUE_SOFT_LIMIT = (4 << 20);
+/**
+ * Clients which let their queue grow over this limit (for example, because
+ * they never read their responses) are disconnected.
+ */
+static constexpr size_t OUTPUT_QUEUE_HARD_LIMIT = (64 << 20);
+
+/** Maximal number of buffers passed to a single sendmsg() call. */
+static constexpr int MAX_IOV_PER_WRITE = 64;
+
 wf::ipc::client_t::client_t(server_t *ipc, int fd)
 {
     LOGD("New IPC client, fd ", fd);
@@ -160,113 +236,253 @@ wf::ipc::client_t::client_t(server_t *ipc, int fd)
     source = wl_event_loop_add_fd(ev_loop, fd, WL_EVENT_READABLE,
         wl_loop_handle_ipc_client_fd_event, this);
 
-    // +1 for null byte at the end
-    buffer.resize(MAX_MESSAGE_LEN + 1);
+    // Enough space for the longest possible message, which means that we can
+    // always make progress.
+    buffer.resize(MAX_MESSAGE_LEN);
 }
 
-// -1 error, 0 success, 1 try again later
-int wf::ipc::client_t::read_up_to(int n, int *available)
+bool wf::ipc::client_t::is_closing() const
 {
-    int need = n - current_buffer_valid;
-    int want = std::min(need, *available);
+    return closing;
+}
 
-    while (want > 0)
+void wf::ipc::client_t::close_later()
+{
+    if (!closing)
+    {
+        closing = true;
+        wl_event_source_fd_update(source, 0);
+        ipc->schedule_cleanup();
+    }
+}
+
+bool wf::ipc::client_t::read_available()
+{
+    while (buffer_valid < buffer.size())
     {
-        int r = read(fd, buffer.data() + current_buffer_valid, want);
-        if (r <= 0)
+        ssize_t r = read(fd, buffer.data() + buffer_valid, buffer.size() - buffer_valid);
+        if (r > 0)
         {
-            LOGI("Read: EOF or error (%d) %s\n", r, strerror(errno));
-            return -1;
+            buffer_valid += r;
+            continue;
         }
 
-        want -= r;
-        *available -= r;
-        current_buffer_valid += r;
-    }
+        if ((r < 0) && (errno == EINTR))
+        {
+            continue;
+        }
 
-    if (current_buffer_valid < n)
-    {
-        // didn't read all n letters
-        return 1;
+        if ((r < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            return true;
+        }
+
+        if (r == 0)
+        {
+            // The requests read until now still get their responses
+            input_closed = true;
+            return true;
+        }
+
+        LOGI("Read: error ", strerror(errno));
+        return false;
     }
 
-    return 0;
+    return true;
 }
 
-void wf::ipc::client_t::handle_fd_activity(uint32_t event_mask)
+bool wf::ipc::client_t::handle_buffered_requests()
 {
-    if (event_mask & (WL_EVENT_ERROR | WL_EVENT_HANGUP))
+    size_t consumed = 0;
+    while (!reading_paused && (buffer_valid - consumed >= HEADER_LEN))
     {
-        ipc->client_disappeared(this);
-        // this no longer exists
-        return;
-    }
+        uint32_t len;
+        std::memcpy(&len, buffer.data() + consumed, HEADER_LEN);
+        if (len > MAX_MESSAGE_LEN - HEADER_LEN)
+        {
+            LOGE("Client tried to pass too long a message!");
+            return false;
+        }
 
-    int available = 0;
-    if (ioctl(this->fd, FIONREAD, &available) != 0)
-    {
-        LOGE("Failed to inspect message buffer!");
-        ipc->client_disappeared(this);
-        return;
-    }
+        if (buffer_valid - consumed < HEADER_LEN + len)
+        {
+            // Wait for the rest of the message
+            break;
+        }
 
-    while (available > 0)
-    {
-        if (current_buffer_valid < HEADER_LEN)
+        // Parse directly from the receive buffer
+        const char *str = buffer.data() + consumed + HEADER_LEN;
+        auto message    = decode_message(str, len, encoding);
+        consumed += HEADER_LEN + len;
+
+        if (message.is_discarded())
         {
-            if (read_up_to(HEADER_LEN, &available) < 0)
+            if (encoding == encoding_t::JSON)
+            {
+                LOGE("Client's message could not be parsed: ", std::string(str, len));
+            } else
             {
-                ipc->client_disappeared(this);
-                return;
+                LOGE("Client's binary message could not be parsed.");
             }
 
-            continue;
+            return false;
         }
 
-        const uint32_t len = *((uint32_t*)buffer.data());
-        if (len > MAX_MESSAGE_LEN - HEADER_LEN)
+        if (!message.contains("method"))
         {
-            LOGE("Client tried to pass too long a message!");
-            ipc->client_disappeared(this);
-            return;
+            LOGE("Client's message does not contain a method to be called!");
+            return false;
         }
 
-        const int next_target = HEADER_LEN + len;
-        int r = read_up_to(next_target, &available);
-        if (r < 0)
+        send_json(ipc->call_method(message["method"], message["data"], this));
+        encoding = next_encoding;
+        if (closing)
         {
-            ipc->client_disappeared(this);
-            return;
+            return false;
         }
+    }
 
-        if (r > 0)
+    // Move the incomplete message (if any) to the start of the buffer
+    if (consumed > 0)
+    {
+        std::memmove(buffer.data(), buffer.data() + consumed, buffer_valid - consumed);
+        buffer_valid -= consumed;
+    }
+
+    return true;
+}
+
+bool wf::ipc::client_t::flush_output()
+{
+    while (!output_queue.empty())
+    {
+        iovec iov[MAX_IOV_PER_WRITE];
+        int nr_iov = 0;
+        for (auto it = output_queue.begin();
+             (it != output_queue.end()) && (nr_iov < MAX_IOV_PER_WRITE); ++it, ++nr_iov)
         {
-            // Try again
-            continue;
+            size_t skip = (nr_iov == 0) ? output_offset : 0;
+            iov[nr_iov].iov_base = (void*)(it->data() + skip);
+            iov[nr_iov].iov_len  = it->size() - skip;
         }
 
-        // Finally, received the message, make sure we have a terminating NULL byte
-        buffer[current_buffer_valid] = '\0';
-        char *str    = buffer.data() + HEADER_LEN;
-        auto message = nlohmann::json::parse(str, nullptr, false);
-        if (message.is_discarded())
+        // sendmsg() is a writev() which does not raise SIGPIPE if the client is gone.
+        msghdr msg = {};
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = nr_iov;
+        ssize_t written = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written < 0)
         {
-            LOGE("Client's message could not be parsed: ", str);
-            ipc->client_disappeared(this);
-            return;
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                // Resume once the socket is writable again
+                break;
+            }
+
+            LOGI("Write: error ", strerror(errno));
+            return false;
         }
 
-        if (!message.contains("method"))
+        output_queued -= written;
+        while (written > 0)
         {
-            LOGE("Client's message does not contain a method to be called!");
-            ipc->client_disappeared(this);
-            return;
+            size_t left = output_queue.front().size() - output_offset;
+            if ((size_t)written < left)
+            {
+                output_offset += written;
+                break;
+            }
+
+            written -= left;
+            output_offset = 0;
+            output_queue.pop_front();
         }
+    }
+
+    if (output_queue.empty())
+    {
+        reading_paused = false;
+    }
+
+    return true;
+}
+
+void wf::ipc::client_t::update_event_mask()
+{
+    if (closing)
+    {
+        return;
+    }
+
+    uint32_t mask = 0;
+    if (!reading_paused && !input_closed)
+    {
+        mask |= WL_EVENT_READABLE;
+    }
+
+    if (!output_queue.empty())
+    {
+        mask |= WL_EVENT_WRITABLE;
+    }
+
+    wl_event_source_fd_update(source, mask);
+}
+
+void wf::ipc::client_t::handle_fd_activity(uint32_t event_mask)
+{
+    if (closing)
+    {
+        return;
+    }
+
+    if (event_mask & (WL_EVENT_ERROR | WL_EVENT_HANGUP))
+    {
+        ipc->client_disappeared(this);
+        // this no longer exists
+        return;
+    }
+
+    if ((event_mask & WL_EVENT_WRITABLE) && !flush_output())
+    {
+        ipc->client_disappeared(this);
+        return;
+    }
+
+    if ((event_mask & WL_EVENT_READABLE) && !reading_paused && !input_closed &&
+        !read_available())
+    {
+        ipc->client_disappeared(this);
+        return;
+    }
+
+    // Handle all pipelined requests at once, and send the responses in a
+    // single batch afterwards.
+    if (!handle_buffered_requests() || !flush_output())
+    {
+        ipc->client_disappeared(this);
+        return;
+    }
+
+    // Writing may have unblocked requests which were held back
+    if (!reading_paused && (buffer_valid > 0) && !handle_buffered_requests())
+    {
+        ipc->client_disappeared(this);
+        return;
+    }
 
-        send_json(ipc->call_method(message["method"], message["data"]));
-        // Reset for next message
-        current_buffer_valid = 0;
+    // After EOF, wait until all responses have been written
+    if (input_closed && output_queue.empty())
+    {
+        ipc->client_disappeared(this);
+        return;
     }
+
+    update_event_mask();
 }
 
 wf::ipc::client_t::~client_t()
@@ -276,27 +492,116 @@ wf::ipc::client_t::~client_t()
     close(this->fd);
 }
 
-static bool write_exact(int fd, char *buf, int n)
+void wf::ipc::client_t::send_json(const nlohmann::json& json)
+{
+    if (closing)
+    {
+        return;
+    }
+
+    // Reserve space for the header, and fill it in once the length is known
+    std::string message(HEADER_LEN, '\0');
+    encode_message(json, encoding, message);
+    uint32_t len = message.length() - HEADER_LEN;
+    std::memcpy(message.data(), &len, HEADER_LEN);
+
+    output_queued += message.length();
+    output_queue.push_back(std::move(message));
+
+    if (output_queued > OUTPUT_QUEUE_HARD_LIMIT)
+    {
+        LOGE("IPC client does not read its messages, disconnecting it.");
+        close_later();
+        return;
+    }
+
+    if (output_queued >= OUTPUT_QUEUE_SOFT_LIMIT)
+    {
+        reading_paused = true;
+    }
+
+    // The actual write happens when the socket is writable, so that messages
+    // queued in a row are sent together.
+    update_event_mask();
+}
+
+/* ----------------------------- Event handling ------------------------------*/
+
+void wf::ipc::client_t::subscribe(const std::vector<std::string>& events,
+    int rate_limit_ms)
+{
+    subscribed_events.insert(events.begin(), events.end());
+    event_interval_ms = std::max(0, rate_limit_ms);
+}
+
+void wf::ipc::client_t::unsubscribe(const std::vector<std::string>& events)
+{
+    if (events.empty())
+    {
+        subscribed_events.clear();
+    }
+
+    for (auto& ev : events)
+    {
+        subscribed_events.erase(ev);
+    }
+}
+
+bool wf::ipc::client_t::is_subscribed(const std::string& event) const
+{
+    return !closing && subscribed_events.count(event);
+}
+
+void wf::ipc::client_t::queue_event(const std::string& key, nlohmann::json event)
 {
-    while (n > 0)
+    auto it = pending_events.find(key);
+    if (it != pending_events.end())
+    {
+        it->second = std::move(event);
+    } else
     {
-        int w = write(fd, buf, n);
-        if (w <= 0)
+        pending_events.emplace(key, std::move(event));
+        pending_events_order.push_back(key);
+    }
+
+    schedule_send_events();
+}
+
+void wf::ipc::client_t::schedule_send_events()
+{
+    if (idle_send_events.is_connected() || delayed_send_events.is_connected())
+    {
+        return;
+    }
+
+    int64_t wait = last_events_sent + event_interval_ms - wf::get_current_time();
+    if (wait <= 0)
+    {
+        // Coalesce everything which happens in this iteration of the loop
+        idle_send_events.run_once([=] () { send_pending_events(); });
+    } else
+    {
+        delayed_send_events.set_timeout(wait, [=] ()
         {
+            send_pending_events();
             return false;
-        }
+        });
+    }
+}
 
-        n -= w;
+void wf::ipc::client_t::send_pending_events()
+{
+    for (auto& key : pending_events_order)
+    {
+        send_json(pending_events[key]);
     }
 
-    return true;
+    pending_events.clear();
+    pending_events_order.clear();
+    last_events_sent = wf::get_current_time();
 }
 
-void wf::ipc::client_t::send_json(nlohmann::json json)
+void wf::ipc::client_t::set_encoding(encoding_t encoding)
 {
-    std::string buffer = json.dump();
-    uint32_t len = buffer.length();
-
-    write_exact(fd, (char*)&len, 4);
-    write_exact(fd, buffer.data(), len);
+    this->next_encoding = encoding;
 }
@@ -3,8 +3,12 @@
 #include <nlohmann/json.hpp>
 #include <sys/un.h>
 #include <wayfire/object.hpp>
+#include <wayfire/util.hpp>
 #include <variant>
+#include <deque>
+#include <set>
 #include <wayland-server.h>
+#include "ipc-encoding.hpp"
 
 namespace wf
 {
@@ -18,6 +22,11 @@ struct error_response_t
 
 /**
  * Represents a single connected client to the IPC.
+ *
+ * Clients may pipeline several requests without waiting for the responses.
+ * Responses are queued and written to the socket without ever blocking the
+ * compositor. If a client does not read its responses, reading further
+ * requests from it is paused until the output queue has been drained.
  */
 class server_t;
 class client_t
@@ -28,16 +37,84 @@ class client_t
 
     /** Handle incoming data on the socket */
     void handle_fd_activity(uint32_t event_mask);
-    void send_json(nlohmann::json json);
+
+    /**
+     * Queue a message for the client. It will be sent as soon as the socket
+     * becomes writable.
+     */
+    void send_json(const nlohmann::json& json);
+
+    /** @return true if the client has been scheduled for removal. */
+    bool is_closing() const;
+
+    /**
+     * Subscribe the client to the given events.
+     *
+     * @param events The names of the events.
+     * @param rate_limit_ms The minimal interval between two batches of events
+     *   sent to the client. With 0, events are sent once per event loop iteration.
+     */
+    void subscribe(const std::vector<std::string>& events, int rate_limit_ms);
+    /** Unsubscribe from the given events, or from all events if empty. */
+    void unsubscribe(const std::vector<std::string>& events);
+    bool is_subscribed(const std::string& event) const;
+
+    /**
+     * Queue an event for the client. A pending event with the same key is
+     * replaced by the new one, so that the client only receives the last state.
+     */
+    void queue_event(const std::string& key, nlohmann::json event);
+
+    /**
+     * Switch the encoding of the connection. The switch takes effect after
+     * the response to the current request has been sent.
+     */
+    void set_encoding(encoding_t encoding);
 
   private:
     int fd;
     wl_event_source *source;
     server_t *ipc;
 
-    int current_buffer_valid = 0;
+    /* Data received from the client which has not been handled yet. */
+    size_t buffer_valid = 0;
     std::vector<char> buffer;
-    int read_up_to(int n, int *available);
+
+    /* Pending messages, the first of which may be partially written. */
+    std::deque<std::string> output_queue;
+    size_t output_offset = 0;
+    size_t output_queued = 0;
+
+    bool reading_paused = false;
+    bool closing = false;
+    /* The client shut down its writing side, answer what it sent and close */
+    bool input_closed = false;
+
+    encoding_t encoding = encoding_t::JSON;
+    encoding_t next_encoding = encoding_t::JSON;
+
+    /* Events the client is interested in */
+    std::set<std::string> subscribed_events;
+    /* Coalesced events which have not been sent yet, in order of arrival */
+    std::map<std::string, nlohmann::json> pending_events;
+    std::vector<std::string> pending_events_order;
+    int event_interval_ms = 0;
+    int64_t last_events_sent = 0;
+    wf::wl_idle_call idle_send_events;
+    wf::wl_timer delayed_send_events;
+    void schedule_send_events();
+    void send_pending_events();
+
+    /** Read as much as possible from the socket. false on error. */
+    bool read_available();
+    /** Handle all complete requests in the buffer. false on error. */
+    bool handle_buffered_requests();
+    /** Write as much of the output queue as possible. false on error. */
+    bool flush_output();
+    /** Update the events we want to be woken up for. */
+    void update_event_mask();
+    /** Schedule the removal of the client, safe to call from any context. */
+    void close_later();
 
     client_t(const client_t&) = delete;
     client_t(client_t&&) = delete;
@@ -49,6 +126,7 @@ class server_t
 {
   public:
     using method_cb = std::function<nlohmann::json(nlohmann::json)>;
+    using client_method_cb = std::function<nlohmann::json(nlohmann::json, client_t*)>;
 
     server_t(std::string socket_path);
     ~server_t();
@@ -60,17 +138,39 @@ class server_t
     void register_method(std::string method, method_cb handler);
     void unregister_method(std::string method);
 
+    // Same as register_method, but the handler also gets the client which sent
+    // the request, for example to subscribe it to events.
+    void register_client_method(std::string method, client_method_cb handler);
+
     // non-copyable, non-movable
     server_t(const server_t&) = delete;
     server_t(server_t&&) = delete;
     server_t& operator =(const server_t&) = delete;
     server_t& operator =(server_t&&) = delete;
 
-    nlohmann::json call_method(std::string method, nlohmann::json data);
+    nlohmann::json call_method(std::string method, nlohmann::json data,
+        client_t *client = nullptr);
+
+    /** @return true if at least one client is subscribed to the event. */
+    bool has_subscribers(const std::string& event) const;
+
+    /**
+     * Send an event to all subscribed clients.
+     *
+     * @param event The name of the event, sent as the "event" field.
+     * @param key Events with the same key are coalesced, e.g. two geometry
+     *   changes of the same view. Empty means event + data is never coalesced.
+     * @param data The event contents.
+     */
+    void send_event(const std::string& event, const std::string& key,
+        nlohmann::json data);
 
     void accept_new_client();
     void client_disappeared(client_t *client);
 
+    /** Remove all clients which are closing, the next time the loop is idle. */
+    void schedule_cleanup();
+
   private:
     int fd;
     /**
@@ -81,8 +181,9 @@ class server_t
     sockaddr_un saddr;
     wl_event_source *source;
 
-    std::map<std::string, method_cb> methods;
+    std::map<std::string, client_method_cb> methods;
     std::vector<std::unique_ptr<client_t>> clients;
+    wf::wl_idle_call idle_cleanup;
 };
 }
 }
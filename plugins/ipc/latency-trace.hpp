@@ -0,0 +1,406 @@
+#pragma once
+
+#include <wayfire/core.hpp>
+#include <wayfire/view.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/output-layout.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <map>
+#include <memory>
+#include <time.h>
+
+namespace wf
+{
+namespace latency_trace
+{
+/**
+ * A histogram of latencies with 1ms wide buckets. Latencies above the last
+ * bucket are counted in an overflow bucket.
+ */
+class histogram_t
+{
+  public:
+    static constexpr size_t NUM_BUCKETS = 100;
+
+    void add(int64_t us)
+    {
+        us = std::max<int64_t>(us, 0);
+        size_t idx = std::min<size_t>(us / 1000, NUM_BUCKETS);
+        ++buckets[idx];
+        ++count;
+        sum_us += us;
+        max_us  = std::max(max_us, us);
+    }
+
+    /** @return An upper bound for the given percentile (0-100), in ms. */
+    int64_t percentile(int p) const
+    {
+        uint64_t target = (count * p + 99) / 100;
+        uint64_t seen   = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; i++)
+        {
+            seen += buckets[i];
+            if (seen >= std::max<uint64_t>(target, 1))
+            {
+                return i + 1;
+            }
+        }
+
+        return (max_us + 999) / 1000;
+    }
+
+    nlohmann::json to_json() const
+    {
+        nlohmann::json result;
+        result["samples"] = count;
+        if (count == 0)
+        {
+            return result;
+        }
+
+        result["avg-ms"] = sum_us / 1000.0 / count;
+        result["p50-ms"] = percentile(50);
+        result["p90-ms"] = percentile(90);
+        result["p99-ms"] = percentile(99);
+        result["max-ms"] = max_us / 1000.0;
+
+        /* Only non-empty buckets, keyed by their upper bound in ms */
+        nlohmann::json hist = nlohmann::json::array();
+        for (size_t i = 0; i <= NUM_BUCKETS; i++)
+        {
+            if (buckets[i])
+            {
+                hist.push_back({{"le-ms", i < NUM_BUCKETS ? (int64_t)i + 1 : -1},
+                    {"count", buckets[i]}});
+            }
+        }
+
+        result["histogram"] = hist;
+        return result;
+    }
+
+  private:
+    std::array<uint64_t, NUM_BUCKETS + 1> buckets = {};
+    uint64_t count = 0;
+    int64_t sum_us = 0;
+    int64_t max_us = 0;
+};
+
+/**
+ * Measures the time from an input event until the client which received it
+ * reacts (its next commit) and until that commit becomes visible (the
+ * presentation of the first output frame submitted after the commit).
+ *
+ * Key events belong to the view with keyboard focus, pointer and touch events
+ * to the view with pointer or touch focus after core has processed them.
+ *
+ * Input events are tagged when core emits their signals, i.e. before any
+ * processing by plugins. When several input events arrive before the client
+ * commits, the latency is measured from the earliest of them. If the next
+ * event goes to a different view, the pending one is dropped.
+ */
+class tracer_t
+{
+  public:
+    void start()
+    {
+        if (running)
+        {
+            return;
+        }
+
+        running = true;
+        clock   = wlr_backend_get_presentation_clock(wf::get_core().backend);
+
+        auto& core = wf::get_core();
+        core.connect_signal("keyboard_key", &on_key);
+        core.connect_signal("pointer_button", &on_input_start);
+        core.connect_signal("pointer_motion", &on_input_start);
+        core.connect_signal("pointer_motion_absolute", &on_input_start);
+        core.connect_signal("pointer_axis", &on_input_start);
+        core.connect_signal("touch_down", &on_input_start);
+        core.connect_signal("touch_motion", &on_input_start);
+        core.connect_signal("pointer_button_post", &on_pointer_input);
+        core.connect_signal("pointer_motion_post", &on_pointer_input);
+        core.connect_signal("pointer_motion_absolute_post", &on_pointer_input);
+        core.connect_signal("pointer_axis_post", &on_pointer_input);
+        core.connect_signal("touch_down_post", &on_touch_input);
+        core.connect_signal("touch_motion_post", &on_touch_input);
+        core.connect_signal("keyboard-focus-changed", &on_focus_changed);
+        core.output_layout->connect_signal("output-added", &on_output_added);
+        core.output_layout->connect_signal("output-removed", &on_output_removed);
+
+        for (auto& wo : core.output_layout->get_outputs())
+        {
+            add_output(wo);
+        }
+
+        auto active = core.get_active_output();
+        keyboard_focus = active ? active->get_active_view() : nullptr;
+    }
+
+    void stop()
+    {
+        running = false;
+        on_key.disconnect();
+        on_input_start.disconnect();
+        on_pointer_input.disconnect();
+        on_touch_input.disconnect();
+        on_focus_changed.disconnect();
+        on_output_added.disconnect();
+        on_output_removed.disconnect();
+        set_target(nullptr);
+        keyboard_focus = nullptr;
+        outputs.clear();
+    }
+
+    bool is_running() const
+    {
+        return running;
+    }
+
+    /** Drop all collected statistics. */
+    void reset()
+    {
+        for (auto& entry : outputs)
+        {
+            entry.second->to_commit  = {};
+            entry.second->to_present = {};
+            entry.second->samples.clear();
+        }
+    }
+
+    nlohmann::json get_stats() const
+    {
+        nlohmann::json result;
+        result["running"] = running;
+        result["outputs"] = nlohmann::json::object();
+        for (auto& [wo, st] : outputs)
+        {
+            result["outputs"][wo->to_string()] = {
+                {"input-to-commit", st->to_commit.to_json()},
+                {"input-to-present", st->to_present.to_json()},
+            };
+        }
+
+        return result;
+    }
+
+    ~tracer_t()
+    {
+        stop();
+    }
+
+  private:
+    /**
+     * Samples which were not presented after this time are dropped, and so is
+     * pending input the client did not react to in this time.
+     */
+    static constexpr int64_t MAX_SAMPLE_AGE_NS = 1'000'000'000;
+
+    struct sample_t
+    {
+        int64_t input_ns;
+        /** Output commit which contains the client commit, 0 if none yet. */
+        uint32_t commit_seq = 0;
+    };
+
+    struct output_state_t
+    {
+        histogram_t to_commit;
+        histogram_t to_present;
+        std::deque<sample_t> samples;
+        wf::wl_listener_wrapper on_commit;
+        wf::wl_listener_wrapper on_present;
+    };
+
+    bool running = false;
+    clockid_t clock = CLOCK_MONOTONIC;
+
+    /** Earliest input event not yet followed by a commit, -1 if none. */
+    int64_t pending_input = -1;
+    /** Time of the pointer or touch event core is currently processing. */
+    int64_t input_start = -1;
+
+    wayfire_view keyboard_focus;
+    /** The view which received the last input event. */
+    wayfire_view target;
+    wf::wl_listener_wrapper on_surface_commit;
+    wf::wl_listener_wrapper on_surface_destroy;
+    std::map<wf::output_t*, std::unique_ptr<output_state_t>> outputs;
+
+    int64_t now_ns() const
+    {
+        timespec ts;
+        clock_gettime(clock, &ts);
+        return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+    }
+
+    void add_output(wf::output_t *wo)
+    {
+        auto st = std::make_unique<output_state_t>();
+        auto raw = st.get();
+
+        st->on_commit.set_callback([=] (void *data)
+        {
+            auto ev = static_cast<wlr_output_event_commit*>(data);
+            if (!(ev->committed & WLR_OUTPUT_STATE_BUFFER))
+            {
+                return;
+            }
+
+            for (auto& sample : raw->samples)
+            {
+                if (sample.commit_seq == 0)
+                {
+                    sample.commit_seq = wo->handle->commit_seq;
+                }
+            }
+        });
+
+        st->on_present.set_callback([=] (void *data)
+        {
+            auto ev = static_cast<wlr_output_event_present*>(data);
+            int64_t when = ev->when ?
+                ev->when->tv_sec * 1'000'000'000ll + ev->when->tv_nsec : now_ns();
+
+            auto& samples = raw->samples;
+            while (!samples.empty() && samples.front().commit_seq &&
+                   (samples.front().commit_seq <= ev->commit_seq))
+            {
+                if (ev->presented)
+                {
+                    raw->to_present.add((when - samples.front().input_ns) / 1000);
+                }
+
+                samples.pop_front();
+            }
+        });
+
+        st->on_commit.connect(&wo->handle->events.commit);
+        st->on_present.connect(&wo->handle->events.present);
+        outputs[wo] = std::move(st);
+    }
+
+    void set_target(wayfire_view view)
+    {
+        on_surface_commit.disconnect();
+        on_surface_destroy.disconnect();
+        target = view;
+        pending_input = -1;
+
+        wlr_surface *surface = view ? view->get_main_surface()->get_wlr_surface() : nullptr;
+        if (!surface)
+        {
+            target = nullptr;
+            return;
+        }
+
+        on_surface_commit.set_callback([=] (void*) { handle_client_commit(); });
+        on_surface_destroy.set_callback([=] (void*) { set_target(nullptr); });
+        on_surface_commit.connect(&surface->events.commit);
+        on_surface_destroy.connect(&surface->events.destroy);
+    }
+
+    void handle_client_commit()
+    {
+        if (pending_input < 0)
+        {
+            return;
+        }
+
+        int64_t now = now_ns();
+        if (now - pending_input > MAX_SAMPLE_AGE_NS)
+        {
+            /* The client ignored the input, this commit is not a reaction to it */
+            pending_input = -1;
+            return;
+        }
+
+        auto it = outputs.find(target->get_output());
+        if (it != outputs.end())
+        {
+            auto& st = *it->second;
+            st.to_commit.add((now - pending_input) / 1000);
+
+            while (!st.samples.empty() &&
+                   (now - st.samples.front().input_ns > MAX_SAMPLE_AGE_NS))
+            {
+                st.samples.pop_front();
+            }
+
+            st.samples.push_back({pending_input});
+        }
+
+        pending_input = -1;
+    }
+
+    /** Record an input event at the given time, sent to the given view. */
+    void add_input(wayfire_view view, int64_t when)
+    {
+        if (!view || (when < 0))
+        {
+            return;
+        }
+
+        if (view != target)
+        {
+            set_target(view);
+        }
+
+        if (target && (pending_input < 0))
+        {
+            pending_input = when;
+        }
+    }
+
+    wf::signal_connection_t on_key = [=] (wf::signal_data_t*)
+    {
+        add_input(keyboard_focus, now_ns());
+    };
+
+    /* The pointer and touch focus are known only after core has processed the
+     * event, so the time is taken before and the event is recorded after. */
+    wf::signal_connection_t on_input_start = [=] (wf::signal_data_t*)
+    {
+        input_start = now_ns();
+    };
+
+    wf::signal_connection_t on_pointer_input = [=] (wf::signal_data_t*)
+    {
+        add_input(wf::get_core().get_cursor_focus_view(), input_start);
+        input_start = -1;
+    };
+
+    wf::signal_connection_t on_touch_input = [=] (wf::signal_data_t*)
+    {
+        add_input(wf::get_core().get_touch_focus_view(), input_start);
+        input_start = -1;
+    };
+
+    wf::signal_connection_t on_focus_changed = [=] (wf::signal_data_t *data)
+    {
+        auto ev = static_cast<wf::keyboard_focus_changed_signal*>(data);
+        auto vnode = dynamic_cast<wf::scene::view_node_t*>(ev->new_focus.get());
+        keyboard_focus = vnode ? vnode->get_view() : nullptr;
+    };
+
+    wf::signal_connection_t on_output_added = [=] (wf::signal_data_t *data)
+    {
+        add_output(get_signaled_output(data));
+    };
+
+    wf::signal_connection_t on_output_removed = [=] (wf::signal_data_t *data)
+    {
+        outputs.erase(get_signaled_output(data));
+    };
+};
+}
+}
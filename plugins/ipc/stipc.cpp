@@ -3,6 +3,9 @@
 #include <wayfire/output.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/output-layout.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/startup-timeline.hpp>
+#include <wayfire/animation-scheduler.hpp>
 #include <getopt.h>
 #include <wayland-server-protocol.h>
 
@@ -10,6 +13,8 @@
 #include <wayfire/debug.hpp>
 
 #include "ipc.hpp"
+#include "input-trace.hpp"
+#include "latency-trace.hpp"
 #include <wayfire/touch/touch.hpp>
 
 extern "C" {
@@ -220,6 +225,90 @@ class headless_input_backend_t
         wl_signal_emit(&touch.events.frame, NULL);
     }
 
+    /** Feed an event from an input trace, see input-trace.hpp */
+    void feed_trace_event(const input_trace::event_t& event)
+    {
+        uint32_t time = get_current_time();
+        switch (event.type)
+        {
+          case input_trace::KEY:
+            do_key(event.code, (wl_keyboard_key_state)event.state);
+            break;
+
+          case input_trace::POINTER_MOTION:
+          {
+            wlr_pointer_motion_event ev;
+            ev.pointer   = &pointer;
+            ev.time_msec = time;
+            ev.delta_x   = ev.unaccel_dx = event.x;
+            ev.delta_y   = ev.unaccel_dy = event.y;
+            wl_signal_emit(&pointer.events.motion, &ev);
+            wl_signal_emit(&pointer.events.frame, NULL);
+            break;
+          }
+
+          case input_trace::POINTER_MOTION_ABSOLUTE:
+          {
+            wlr_pointer_motion_absolute_event ev;
+            ev.pointer   = &pointer;
+            ev.time_msec = time;
+            ev.x = event.x;
+            ev.y = event.y;
+            wl_signal_emit(&pointer.events.motion_absolute, &ev);
+            wl_signal_emit(&pointer.events.frame, NULL);
+            break;
+          }
+
+          case input_trace::POINTER_BUTTON:
+            do_button(event.code, (wlr_button_state)event.state);
+            break;
+
+          case input_trace::POINTER_AXIS:
+          {
+            wlr_pointer_axis_event ev;
+            ev.pointer     = &pointer;
+            ev.time_msec   = time;
+            ev.orientation = (wlr_axis_orientation)event.code;
+            ev.source = (wlr_axis_source)event.state;
+            ev.delta  = event.x;
+            ev.delta_discrete = event.discrete;
+            wl_signal_emit(&pointer.events.axis, &ev);
+            wl_signal_emit(&pointer.events.frame, NULL);
+            break;
+          }
+
+          case input_trace::TOUCH_DOWN:
+          {
+            wlr_touch_down_event ev;
+            ev.touch     = &touch;
+            ev.time_msec = time;
+            ev.touch_id  = event.code;
+            ev.x = event.x;
+            ev.y = event.y;
+            wl_signal_emit(&touch.events.down, &ev);
+            wl_signal_emit(&touch.events.frame, NULL);
+            break;
+          }
+
+          case input_trace::TOUCH_MOTION:
+          {
+            wlr_touch_motion_event ev;
+            ev.touch     = &touch;
+            ev.time_msec = time;
+            ev.touch_id  = event.code;
+            ev.x = event.x;
+            ev.y = event.y;
+            wl_signal_emit(&touch.events.motion, &ev);
+            wl_signal_emit(&touch.events.frame, NULL);
+            break;
+          }
+
+          case input_trace::TOUCH_UP:
+            do_touch_release(event.code);
+            break;
+        }
+    }
+
     headless_input_backend_t(const headless_input_backend_t&) = delete;
     headless_input_backend_t(headless_input_backend_t&&) = delete;
     headless_input_backend_t& operator =(const headless_input_backend_t&) = delete;
@@ -240,6 +329,42 @@ static inline nlohmann::json get_error(std::string msg)
     };
 }
 
+static nlohmann::json view_to_json(wayfire_view view)
+{
+    nlohmann::json v;
+    v["id"]     = view->get_id();
+    v["title"]  = view->get_title();
+    v["app-id"] = view->get_app_id();
+    v["geometry"] = geometry_to_json(view->get_wm_geometry());
+    v["base-geometry"] = geometry_to_json(view->get_output_geometry());
+    v["state"] = {
+        {"tiled", view->tiled_edges},
+        {"fullscreen", view->fullscreen},
+        {"minimized", view->minimized},
+    };
+
+    uint32_t layer = -1;
+    if (view->get_output())
+    {
+        layer = view->get_output()->workspace->get_view_layer(view);
+    }
+
+    v["layer"] = layer_to_string(layer);
+    return v;
+}
+
+/** Events which clients can subscribe to with core/subscribe. */
+static const std::set<std::string> supported_events = {
+    "view-mapped",
+    "view-unmapped",
+    "view-geometry-changed",
+    "view-focused",
+    "view-title-changed",
+    "workspace-changed",
+    "output-added",
+    "output-removed",
+};
+
 class ipc_plugin_t
 {
   public:
@@ -266,9 +391,38 @@ class ipc_plugin_t
         server->register_method("core/layout_views", layout_views);
         server->register_method("core/touch", do_touch);
         server->register_method("core/touch_release", do_touch_release);
+        server->register_method("core/record_input", record_input);
+        server->register_method("core/stop_recording", stop_recording);
+        server->register_method("core/replay_input", replay_input);
+        server->register_method("core/replay_status", replay_status);
+        server->register_method("core/start_latency_trace", start_latency_trace);
+        server->register_method("core/stop_latency_trace", stop_latency_trace);
+        server->register_method("core/latency_stats", latency_stats);
+        server->register_method("core/startup_timeline", startup_timeline);
+        server->register_method("core/list_animations", list_animations);
+        server->register_client_method("core/subscribe", subscribe);
+        server->register_client_method("core/unsubscribe", unsubscribe);
+
+        wf::get_core().output_layout->connect_signal("output-added", &on_output_added);
+        wf::get_core().output_layout->connect_signal("output-removed",
+            &on_output_removed);
+        wf::get_core().connect_signal("view-geometry-changed", &on_geometry_changed);
+        for (auto& wo : wf::get_core().output_layout->get_outputs())
+        {
+            connect_output_signals(wo);
+        }
+
+        for (auto& view : wf::get_core().get_all_views())
+        {
+            if (view->is_mapped())
+            {
+                connect_view_signals(view);
+            }
+        }
     }
 
     using method_t = ipc::server_t::method_cb;
+    using client_method_t = ipc::server_t::client_method_cb;
 
     method_t list_views = [] (nlohmann::json)
     {
@@ -276,30 +430,194 @@ class ipc_plugin_t
 
         for (auto& view : wf::get_core().get_all_views())
         {
-            nlohmann::json v;
-            v["id"]     = view->get_id();
-            v["title"]  = view->get_title();
-            v["app-id"] = view->get_app_id();
-            v["geometry"] = geometry_to_json(view->get_wm_geometry());
-            v["base-geometry"] = geometry_to_json(view->get_output_geometry());
-            v["state"] = {
-                {"tiled", view->tiled_edges},
-                {"fullscreen", view->fullscreen},
-                {"minimized", view->minimized},
-            };
+            response.push_back(view_to_json(view));
+        }
+
+        return response;
+    };
+
+    /**
+     * Parse the list of events in a (un)subscribe request.
+     * @return An error message, or an empty string on success.
+     */
+    static std::string parse_events(nlohmann::json& data,
+        std::vector<std::string>& events)
+    {
+        if (!data.count("events"))
+        {
+            return "";
+        }
+
+        if (!data["events"].is_array())
+        {
+            return "Field \"events\" does not have the correct type array";
+        }
 
-            uint32_t layer = -1;
-            if (view->get_output())
+        for (auto& ev : data["events"])
+        {
+            if (!ev.is_string() || !supported_events.count(ev))
             {
-                layer = view->get_output()->workspace->get_view_layer(view);
+                return "Unknown event " + ev.dump();
             }
 
-            v["layer"] = layer_to_string(layer);
+            events.push_back(ev);
+        }
+
+        return "";
+    }
 
-            response.push_back(v);
+    client_method_t subscribe = [=] (nlohmann::json data, ipc::client_t *client)
+    {
+        EXPECT_FIELD(data, "events", array);
+        std::vector<std::string> events;
+        auto error = parse_events(data, events);
+        if (!error.empty())
+        {
+            return get_error(error);
         }
 
-        return response;
+        int rate_limit = 0;
+        if (data.count("rate-limit"))
+        {
+            EXPECT_FIELD(data, "rate-limit", number_integer);
+            rate_limit = data["rate-limit"];
+        }
+
+        client->subscribe(events, rate_limit);
+        return get_ok();
+    };
+
+    client_method_t unsubscribe = [=] (nlohmann::json data, ipc::client_t *client)
+    {
+        std::vector<std::string> events;
+        auto error = parse_events(data, events);
+        if (!error.empty())
+        {
+            return get_error(error);
+        }
+
+        client->unsubscribe(events);
+        return get_ok();
+    };
+
+    void connect_output_signals(wf::output_t *output)
+    {
+        output->connect_signal("view-mapped", &on_view_mapped);
+        output->connect_signal("view-unmapped", &on_view_unmapped);
+        output->connect_signal("view-focused", &on_view_focused);
+        output->connect_signal("focus-view", &on_focus_cleared);
+        output->connect_signal("workspace-changed", &on_workspace_changed);
+    }
+
+    void connect_view_signals(wayfire_view view)
+    {
+        view->connect_signal("title-changed", &on_title_changed);
+        view->connect_signal("app-id-changed", &on_title_changed);
+    }
+
+    wf::signal_connection_t on_output_added = [=] (wf::signal_data_t *data)
+    {
+        auto output = get_signaled_output(data);
+        connect_output_signals(output);
+        if (server->has_subscribers("output-added"))
+        {
+            server->send_event("output-added", "", {{"output", output->to_string()}});
+        }
+    };
+
+    wf::signal_connection_t on_output_removed = [=] (wf::signal_data_t *data)
+    {
+        if (server->has_subscribers("output-removed"))
+        {
+            auto output = get_signaled_output(data);
+            server->send_event("output-removed", "", {{"output", output->to_string()}});
+        }
+    };
+
+    wf::signal_connection_t on_view_mapped = [=] (wf::signal_data_t *data)
+    {
+        auto view = get_signaled_view(data);
+        connect_view_signals(view);
+        if (server->has_subscribers("view-mapped"))
+        {
+            server->send_event("view-mapped", std::to_string(view->get_id()),
+                {{"view", view_to_json(view)}});
+        }
+    };
+
+    wf::signal_connection_t on_view_unmapped = [=] (wf::signal_data_t *data)
+    {
+        auto view = get_signaled_view(data);
+        view->disconnect_signal(&on_title_changed);
+        if (server->has_subscribers("view-unmapped"))
+        {
+            server->send_event("view-unmapped", std::to_string(view->get_id()),
+                {{"id", view->get_id()}});
+        }
+    };
+
+    wf::signal_connection_t on_geometry_changed = [=] (wf::signal_data_t *data)
+    {
+        if (server->has_subscribers("view-geometry-changed"))
+        {
+            auto view = get_signaled_view(data);
+            server->send_event("view-geometry-changed", std::to_string(view->get_id()),
+                {
+                    {"id", view->get_id()},
+                    {"geometry", geometry_to_json(view->get_wm_geometry())},
+                });
+        }
+    };
+
+    void send_view_focused(wayfire_view view)
+    {
+        if (server->has_subscribers("view-focused"))
+        {
+            // Only the last focus change matters, so all of them are coalesced
+            server->send_event("view-focused", "focus",
+                {{"id", view ? (int64_t)view->get_id() : -1}});
+        }
+    }
+
+    wf::signal_connection_t on_view_focused = [=] (wf::signal_data_t *data)
+    {
+        send_view_focused(get_signaled_view(data));
+    };
+
+    /* view-focused is not emitted when the focus is cleared, only focus-view */
+    wf::signal_connection_t on_focus_cleared = [=] (wf::signal_data_t *data)
+    {
+        if (!get_signaled_view(data))
+        {
+            send_view_focused(nullptr);
+        }
+    };
+
+    wf::signal_connection_t on_title_changed = [=] (wf::signal_data_t *data)
+    {
+        if (server->has_subscribers("view-title-changed"))
+        {
+            auto view = get_signaled_view(data);
+            server->send_event("view-title-changed", std::to_string(view->get_id()),
+                {
+                    {"id", view->get_id()},
+                    {"title", view->get_title()},
+                    {"app-id", view->get_app_id()},
+                });
+        }
+    };
+
+    wf::signal_connection_t on_workspace_changed = [=] (wf::signal_data_t *data)
+    {
+        if (server->has_subscribers("workspace-changed"))
+        {
+            auto ev = static_cast<wf::workspace_changed_signal*>(data);
+            server->send_event("workspace-changed", ev->output->to_string(),
+                {
+                    {"output", ev->output->to_string()},
+                    {"workspace", {{"x", ev->new_viewport.x}, {"y", ev->new_viewport.y}}},
+                });
+        }
     };
 
     method_t layout_views = [] (nlohmann::json data)
@@ -520,6 +838,159 @@ class ipc_plugin_t
         return get_ok();
     };
 
+    method_t record_input = [=] (nlohmann::json data)
+    {
+        EXPECT_FIELD(data, "file", string);
+        if (!recorder.start(data["file"]))
+        {
+            return get_error("Failed to open " + (std::string)data["file"]);
+        }
+
+        return get_ok();
+    };
+
+    method_t stop_recording = [=] (nlohmann::json data)
+    {
+        if (!recorder.is_recording())
+        {
+            return get_error("Not recording");
+        }
+
+        auto response = get_ok();
+        response["events"] = recorder.stop();
+        return response;
+    };
+
+    method_t replay_input = [=] (nlohmann::json data)
+    {
+        EXPECT_FIELD(data, "file", string);
+        double speed = 1.0;
+        if (data.count("speed"))
+        {
+            EXPECT_FIELD(data, "speed", number);
+            speed = data["speed"];
+        }
+
+        std::vector<input_trace::event_t> events;
+        if (!input_trace::load_trace(data["file"], events))
+        {
+            return get_error("Failed to load trace " + (std::string)data["file"]);
+        }
+
+        auto response = get_ok();
+        response["events"] = events.size();
+        replayer.start(std::move(events), speed, [=] (const input_trace::event_t& ev)
+        {
+            input->feed_trace_event(ev);
+        });
+        return response;
+    };
+
+    method_t replay_status = [=] (nlohmann::json data)
+    {
+        nlohmann::json response;
+        response["running"]   = replayer.is_running();
+        response["processed"] = replayer.get_processed();
+        response["total"] = replayer.get_total();
+
+        auto latencies = replayer.get_latencies();
+        if (!latencies.empty())
+        {
+            std::sort(latencies.begin(), latencies.end());
+            double sum = 0;
+            for (auto& l : latencies)
+            {
+                sum += l;
+            }
+
+            const size_t n = latencies.size();
+            response["latency-us"] = {
+                {"avg", sum / n},
+                {"p50", latencies[n / 2]},
+                {"p99", latencies[std::min(n - 1, n * 99 / 100)]},
+                {"max", latencies.back()},
+            };
+        }
+
+        return response;
+    };
+
+    method_t start_latency_trace = [=] (nlohmann::json data)
+    {
+        latency.start();
+        return get_ok();
+    };
+
+    method_t stop_latency_trace = [=] (nlohmann::json data)
+    {
+        auto response = latency.get_stats();
+        latency.stop();
+        return response;
+    };
+
+    /**
+     * Report input latency histograms per output. Pass `reset: true` to start
+     * collecting a fresh set of samples afterwards.
+     */
+    method_t latency_stats = [=] (nlohmann::json data)
+    {
+        auto response = latency.get_stats();
+        if (data.count("reset"))
+        {
+            EXPECT_FIELD(data, "reset", boolean);
+            if (data["reset"])
+            {
+                latency.reset();
+            }
+        }
+
+        return response;
+    };
+
+    method_t startup_timeline = [=] (nlohmann::json data)
+    {
+        nlohmann::json response;
+        response["timeline"] = nlohmann::json::array();
+        for (auto& ev : wf::get_startup_timeline())
+        {
+            response["timeline"].push_back({
+                {"phase", ev.phase},
+                {"detail", ev.detail},
+                {"start-ms", ev.start_ms},
+                {"duration-ms", ev.duration_ms},
+            });
+        }
+
+        return response;
+    };
+
+    method_t list_animations = [=] (nlohmann::json data)
+    {
+        nlohmann::json response;
+        response["outputs"] = nlohmann::json::array();
+        for (auto& wo : wf::get_core().output_layout->get_outputs())
+        {
+            auto animations = nlohmann::json::array();
+            for (auto& anim : wf::animation_scheduler_t::get(wo).list())
+            {
+                animations.push_back({
+                    {"name", anim.name},
+                    {"frames", anim.frames},
+                    {"running-ms", anim.running_ms},
+                    {"max-frame-gap-ms", anim.max_frame_gap_ms},
+                    {"max-step-us", anim.max_step_us},
+                });
+            }
+
+            response["outputs"].push_back({
+                {"output", wo->to_string()},
+                {"animations", animations},
+            });
+        }
+
+        return response;
+    };
+
     method_t get_display = [=] (nlohmann::json data)
     {
         nlohmann::json dpy;
@@ -528,6 +999,9 @@ class ipc_plugin_t
         return dpy;
     };
 
+    input_trace::recorder_t recorder;
+    input_trace::replayer_t replayer;
+    latency_trace::tracer_t latency;
     std::unique_ptr<ipc::server_t> server;
     std::unique_ptr<headless_input_backend_t> input;
 };
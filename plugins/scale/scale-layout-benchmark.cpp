@@ -0,0 +1,125 @@
+/**
+ * Compares the scale layout computation as it was done before
+ * scale_layout::compute_layout() with the current one, for many views as in
+ * the "all workspaces" mode. Also reports how many views have to be
+ * animated when a single view is closed.
+ *
+ * Usage: scale-layout-benchmark [iterations]
+ */
+#include "scale-layout.hpp"
+#include "bench-util.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace
+{
+/** The row sorting as it was done before compute_layout(). */
+std::vector<std::vector<size_t>> old_view_sort(
+    const std::vector<wf::geometry_t>& views)
+{
+    auto compare_x = [&] (size_t a, size_t b)
+    {
+        auto vg_a = views[a];
+        std::vector<int> a_coords = {vg_a.x, vg_a.width, vg_a.y, vg_a.height};
+        auto vg_b = views[b];
+        std::vector<int> b_coords = {vg_b.x, vg_b.width, vg_b.y, vg_b.height};
+        return a_coords < b_coords;
+    };
+
+    auto compare_y = [&] (size_t a, size_t b)
+    {
+        auto vg_a = views[a];
+        std::vector<int> a_coords = {vg_a.y, vg_a.height, vg_a.x, vg_a.width};
+        auto vg_b = views[b];
+        std::vector<int> b_coords = {vg_b.y, vg_b.height, vg_b.x, vg_b.width};
+        return a_coords < b_coords;
+    };
+
+    std::vector<size_t> order(views.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::vector<std::vector<size_t>> view_grid;
+    std::sort(order.begin(), order.end(), compare_y);
+
+    int rows = sqrt(order.size() + 1);
+    int views_per_row = (int)std::ceil((double)order.size() / rows);
+    size_t n = order.size();
+    for (size_t i = 0; i < n; i += views_per_row)
+    {
+        size_t j = std::min(i + views_per_row, n);
+        view_grid.emplace_back(order.begin() + i, order.begin() + j);
+        std::sort(view_grid.back().begin(), view_grid.back().end(), compare_x);
+    }
+
+    return view_grid;
+}
+
+/** Random views on a 3x3 grid of 1920x1080 workspaces. */
+std::vector<wf::geometry_t> random_views(size_t count, std::mt19937& gen)
+{
+    std::uniform_int_distribution<int> ws(0, 2);
+    std::uniform_int_distribution<int> pos(0, 1000);
+    std::uniform_int_distribution<int> size(200, 900);
+
+    std::vector<wf::geometry_t> views(count);
+    for (auto& g : views)
+    {
+        g = {ws(gen) * 1920 + pos(gen), ws(gen) * 1080 + pos(gen) / 2,
+            size(gen), size(gen)};
+    }
+
+    return views;
+}
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 1000;
+    const wf::geometry_t workarea = {0, 0, 1920, 1080};
+    const int spacing = 50;
+
+    for (size_t count : {50, 200, 500, 1000})
+    {
+        std::mt19937 gen(count);
+        auto views = random_views(count, gen);
+
+        volatile size_t sink = 0;
+        double old_us = wf::bench::average_us(iterations, [&]
+        {
+            sink += old_view_sort(views).size();
+        });
+        double new_us = wf::bench::average_us(iterations, [&]
+        {
+            sink += wf::scale_layout::compute_layout(views, workarea, spacing).slots.size();
+        });
+
+        /* Close a view in the middle and count the views whose slot changed */
+        auto before = wf::scale_layout::compute_layout(views, workarea, spacing);
+        auto closed = views.begin() + count / 2;
+        views.erase(closed);
+        auto after = wf::scale_layout::compute_layout(views, workarea, spacing);
+
+        std::vector<const wf::scale_layout::slot_t*> old_slot(count);
+        for (auto& slot : before.slots)
+        {
+            old_slot[slot.index] = &slot;
+        }
+
+        size_t moved = 0;
+        for (auto& slot : after.slots)
+        {
+            size_t old_index = slot.index + (slot.index >= count / 2);
+            auto& old = *old_slot[old_index];
+            moved += (old.x != slot.x) || (old.y != slot.y) ||
+                (old.width != slot.width) || (old.height != slot.height);
+        }
+
+        std::cout << count << " views: old sort " << old_us << " us, layout " <<
+            new_us << " us (" << old_us / new_us << "x), " << moved << " of " <<
+            count - 1 << " views move after closing one" << std::endl;
+    }
+
+    return 0;
+}
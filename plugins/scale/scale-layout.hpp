@@ -0,0 +1,113 @@
+#pragma once
+
+#include <wayfire/geometry.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+namespace wf
+{
+namespace scale_layout
+{
+/** The place of a view in the scale grid. */
+struct slot_t
+{
+    /* Index of the view in the input of compute_layout() */
+    size_t index;
+    int row, col;
+    /* The rectangle reserved for the view, the view is scaled to fit inside */
+    double x, y, width, height;
+
+    bool operator ==(const slot_t& other) const
+    {
+        return std::tie(index, row, col, x, y, width, height) ==
+               std::tie(other.index, other.row, other.col, other.x, other.y,
+            other.width, other.height);
+    }
+};
+
+/** The result of compute_layout(). */
+struct layout_t
+{
+    /* The slots, ordered by row and then by column */
+    std::vector<slot_t> slots;
+    /* The number of views in each row */
+    std::vector<int> row_sizes;
+};
+
+/**
+ * Arrange views in a grid of rows, roughly in the order in which they are
+ * on screen: the views are divided in rows by their y coordinate, and each
+ * row is ordered by the x coordinate.
+ *
+ * This function does not depend on any compositor state, so it can be
+ * tested and benchmarked in isolation.
+ *
+ * @param views The geometries of the views to arrange.
+ * @param workarea The area to fill.
+ * @param spacing The gap between the slots and around the grid.
+ */
+inline layout_t compute_layout(const std::vector<wf::geometry_t>& views,
+    wf::geometry_t workarea, int spacing)
+{
+    layout_t layout;
+    const size_t n = views.size();
+    if (n == 0)
+    {
+        return layout;
+    }
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&] (size_t a, size_t b)
+    {
+        auto& ga = views[a];
+        auto& gb = views[b];
+        return std::tie(ga.y, ga.height, ga.x, ga.width) <
+               std::tie(gb.y, gb.height, gb.x, gb.width);
+    });
+
+    const int rows = std::sqrt(n + 1);
+    const size_t views_per_row = (size_t)std::ceil((double)n / rows);
+    const size_t cnt_rows = (n + views_per_row - 1) / views_per_row;
+    const double scaled_height = std::max((double)
+        (workarea.height - ((int)cnt_rows + 1) * spacing) / cnt_rows, 1.0);
+
+    layout.slots.reserve(n);
+    layout.row_sizes.reserve(cnt_rows);
+    for (size_t i = 0, row = 0; i < n; i += views_per_row, row++)
+    {
+        const size_t j = std::min(i + views_per_row, n);
+        std::sort(order.begin() + i, order.begin() + j, [&] (size_t a, size_t b)
+        {
+            auto& ga = views[a];
+            auto& gb = views[b];
+            return std::tie(ga.x, ga.width, ga.y, ga.height) <
+                   std::tie(gb.x, gb.width, gb.y, gb.height);
+        });
+
+        const size_t cnt_cols = j - i;
+        layout.row_sizes.push_back(cnt_cols);
+        const double scaled_width = std::max((double)
+            (workarea.width - ((int)cnt_cols + 1) * spacing) / cnt_cols, 1.0);
+
+        for (size_t col = 0; col < cnt_cols; col++)
+        {
+            layout.slots.push_back(slot_t{
+                .index  = order[i + col],
+                .row    = (int)row,
+                .col    = (int)col,
+                .x      = workarea.x + spacing + (spacing + scaled_width) * col,
+                .y      = workarea.y + spacing + (spacing + scaled_height) * row,
+                .width  = scaled_width,
+                .height = scaled_height,
+            });
+        }
+    }
+
+    return layout;
+}
+}
+}
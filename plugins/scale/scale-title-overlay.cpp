@@ -12,6 +12,7 @@
 #include <wayfire/opengl.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/plugins/common/cairo-util.hpp>
+#include <wayfire/plugins/common/glyph-text.hpp>
 #include <wayfire/plugins/common/simple-texture.hpp>
 #include <wayfire/scene.hpp>
 #include <wayfire/scene-render.hpp>
@@ -35,45 +36,28 @@ static wayfire_view find_toplevel_parent(wayfire_view view)
 struct view_title_texture_t : public wf::custom_data_t
 {
     wayfire_view view;
-    wf::cairo_text_t overlay;
-    wf::cairo_text_t::params par;
-    bool overflow = false;
+    wf::glyph_text_t overlay;
+    wf::glyph_text_t::params par;
     wayfire_view dialog; /* the texture should be rendered on top of this dialog */
 
     /**
-     * Render the overlay text in our texture, cropping it to the size by
-     * the given box.
+     * Update the overlay text, cropping it to the size by the given box.
+     * Only reshapes the text if the title or the scale changed.
      */
     void update_overlay_texture(wf::dimensions_t dim)
     {
         par.max_size = dim;
-        update_overlay_texture();
+        overlay.set_text(view->get_title(), par);
     }
 
-    void update_overlay_texture()
-    {
-        auto res = overlay.render_text(view->get_title(), par);
-        overflow = res.width > overlay.tex.width;
-    }
-
-    wf::signal_connection_t view_changed = [this] (auto)
-    {
-        if (overlay.tex.tex != (GLuint) - 1)
-        {
-            update_overlay_texture();
-        }
-    };
-
     view_title_texture_t(wayfire_view v, int font_size, const wf::color_t& bg_color,
         const wf::color_t& text_color, float output_scale) : view(v)
     {
         par.font_size    = font_size;
         par.bg_color     = bg_color;
         par.text_color   = text_color;
-        par.exact_size   = true;
+        par.bg_rect      = true;
         par.output_scale = output_scale;
-
-        view->connect_signal("title-changed", &view_changed);
     }
 };
 
@@ -195,28 +179,19 @@ class title_overlay_node_t : public node_t
         auto box = find_maximal_title_size();
         auto output_scale = parent.output->handle->scale;
 
-        /**
-         * regenerate the overlay texture in the following cases:
-         * 1. Output's scale changed
-         * 2. The overlay does not fit anymore
-         * 3. The overlay previously did not fit, but there is more space now
-         * TODO: check if this wastes too high CPU power when views are being
-         * animated and maybe redraw less frequently
-         */
+        /* Updating the text is cheap unless the title or the scale changed,
+         * because glyphs are cached in the shared atlas. */
         auto& tex = get_overlay_texture(find_toplevel_parent(view));
-        if ((tex.overlay.tex.tex == (GLuint) - 1) ||
-            (output_scale != tex.par.output_scale) ||
-            (tex.overlay.tex.width > box.width * output_scale) ||
-            (tex.overflow &&
-             (tex.overlay.tex.width < std::floor(box.width * output_scale))))
+        auto old_size = tex.overlay.get_size();
+        tex.par.output_scale = output_scale;
+        tex.update_overlay_texture({box.width, box.height});
+        if (tex.overlay.get_size() != old_size)
         {
             this->do_push_damage(get_bounding_box());
-            tex.par.output_scale = output_scale;
-            tex.update_overlay_texture({box.width, box.height});
         }
 
-        geometry.width  = tex.overlay.tex.width / output_scale;
-        geometry.height = tex.overlay.tex.height / output_scale;
+        geometry.width  = tex.overlay.get_size().width / output_scale;
+        geometry.height = tex.overlay.get_size().height / output_scale;
 
         auto bbox = get_scaled_bbox(view);
         geometry.x = bbox.x + bbox.width / 2 - geometry.width / 2;
@@ -248,10 +223,10 @@ class title_overlay_node_t : public node_t
         auto parent = find_toplevel_parent(view);
         auto& title = get_overlay_texture(parent);
 
-        if (title.overlay.tex.tex != (GLuint) - 1)
+        if (title.overlay.get_size().height > 0)
         {
             text_height = (unsigned int)std::ceil(
-                title.overlay.tex.height / title.par.output_scale);
+                title.overlay.get_size().height / title.par.output_scale);
         } else
         {
             text_height =
@@ -334,21 +309,11 @@ class title_overlay_render_instance_t : public render_instance_t
         auto tr     = self->view->get_transformed_node()
             ->get_transformer<wf::scene::view_2d_transformer_t>("scale");
 
-        GLuint tex = title.overlay.tex.tex;
-
-        if (tex == (GLuint) - 1)
-        {
-            /* this should not happen */
-            return;
-        }
-
-        auto ortho = target.get_orthographic_projection();
         OpenGL::render_begin(target);
         for (const auto& box : region)
         {
             target.logic_scissor(wlr_box_from_pixman_box(box));
-            OpenGL::render_transformed_texture(tex, self->geometry, ortho,
-                {1.0f, 1.0f, 1.0f, tr->alpha}, OpenGL::TEXTURE_TRANSFORM_INVERT_Y);
+            title.overlay.render(target, {self->geometry.x, self->geometry.y}, tr->alpha);
         }
 
         OpenGL::render_end();
@@ -3,11 +3,14 @@
  */
 #include <map>
 #include <memory>
+#include <optional>
+#include <tuple>
 #include <wayfire/plugin.hpp>
 #include <wayfire/output.hpp>
 #include <wayfire/util/duration.hpp>
 #include <wayfire/view-transform.hpp>
 #include <wayfire/render-manager.hpp>
+#include <wayfire/animation-scheduler.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/signal-definitions.hpp>
 #include <wayfire/plugins/vswitch.hpp>
@@ -23,6 +26,7 @@
 
 #include "scale.hpp"
 #include "scale-title-overlay.hpp"
+#include "scale-layout.hpp"
 #include "wayfire/core.hpp"
 #include "wayfire/debug.hpp"
 #include "wayfire/scene-input.hpp"
@@ -61,6 +65,11 @@ struct view_scale_data
     };
 
     view_visibility_t visibility = view_visibility_t::VISIBLE;
+
+    /* Target scale, translation and alpha set by the last layout_slots(). If
+     * the next layout computes the same values, the view is left alone
+     * instead of restarting its animation. Cleared by any other transform. */
+    std::optional<std::tuple<double, double, double, double>> layout_target;
 };
 
 /**
@@ -91,6 +100,8 @@ class wayfire_scale : public wf::plugin_interface_t,
     std::vector<int> current_row_sizes;
     wf::point_t initial_workspace;
     bool active, hook_set;
+    /* Whether transform_views() is stepped by the animation scheduler */
+    bool transform_scheduled = false;
     /* View that was active before scale began. */
     wayfire_view initial_focus_view;
     /* View that has active focus. */
@@ -200,6 +211,7 @@ class wayfire_scale : public wf::plugin_interface_t,
         }
 
         auto tr = std::make_shared<wf::scene::view_2d_transformer_t>(view);
+        tr->use_thumbnail = true;
         scale_data[view].transformer = tr;
         view->get_transformed_node()->add_transformer(tr, wf::TRANSFORMER_2D,
             "scale");
@@ -389,6 +401,7 @@ class wayfire_scale : public wf::plugin_interface_t,
         set_hook();
         auto alpha = scale_data[view].transformer->alpha;
         scale_data[view].fade_animation.animate(alpha, 1);
+        schedule_transform();
         if (view->children.size())
         {
             fade_in(view->children.front());
@@ -415,6 +428,8 @@ class wayfire_scale : public wf::plugin_interface_t,
             auto alpha = scale_data[v].transformer->alpha;
             scale_data[v].fade_animation.animate(alpha, (double)inactive_alpha);
         }
+
+        schedule_transform();
     }
 
     /* Switch to the workspace for the untransformed view geometry */
@@ -816,6 +831,7 @@ class wayfire_scale : public wf::plugin_interface_t,
         double translation_y,
         double target_alpha)
     {
+        view_data.layout_target.reset();
         view_data.animation.scale_animation.scale_x.set(
             view_data.transformer->scale_x, scale_x);
         view_data.animation.scale_animation.scale_y.set(
@@ -829,44 +845,7 @@ class wayfire_scale : public wf::plugin_interface_t,
             wf::option_wrapper_t<int>{"scale/duration"});
         view_data.fade_animation.animate(view_data.transformer->alpha,
             target_alpha);
-    }
-
-    static bool view_compare_x(const wayfire_view& a, const wayfire_view& b)
-    {
-        auto vg_a = a->get_wm_geometry();
-        std::vector<int> a_coords = {vg_a.x, vg_a.width, vg_a.y, vg_a.height};
-        auto vg_b = b->get_wm_geometry();
-        std::vector<int> b_coords = {vg_b.x, vg_b.width, vg_b.y, vg_b.height};
-        return a_coords < b_coords;
-    }
-
-    static bool view_compare_y(const wayfire_view& a, const wayfire_view& b)
-    {
-        auto vg_a = a->get_wm_geometry();
-        std::vector<int> a_coords = {vg_a.y, vg_a.height, vg_a.x, vg_a.width};
-        auto vg_b = b->get_wm_geometry();
-        std::vector<int> b_coords = {vg_b.y, vg_b.height, vg_b.x, vg_b.width};
-        return a_coords < b_coords;
-    }
-
-    std::vector<std::vector<wayfire_view>> view_sort(
-        std::vector<wayfire_view>& views)
-    {
-        std::vector<std::vector<wayfire_view>> view_grid;
-        std::sort(views.begin(), views.end(), view_compare_y);
-
-        int rows = sqrt(views.size() + 1);
-        int views_per_row = (int)std::ceil((double)views.size() / rows);
-        size_t n = views.size();
-        for (size_t i = 0; i < n; i += views_per_row)
-        {
-            size_t j = std::min(i + views_per_row, n);
-            view_grid.emplace_back(views.begin() + i, views.begin() + j);
-            std::sort(view_grid.back().begin(), view_grid.back().end(),
-                view_compare_x);
-        }
-
-        return view_grid;
+        schedule_transform();
     }
 
     /* Filter the views to be arranged by layout_slots() */
@@ -908,7 +887,12 @@ class wayfire_scale : public wf::plugin_interface_t,
 
     /* Compute target scale layout geometry for all the view transformers
      * and start animating. Initial code borrowed from the compiz scale
-     * plugin algorithm */
+     * plugin algorithm.
+     *
+     * The layout is always recomputed for all views: the number of rows depends
+     * on the view count, so adding or removing a view may shift every row.
+     * compute_layout() is cheap, what is expensive is restarting animations,
+     * so only views whose target transform changed are animated again. */
     void layout_slots(std::vector<wayfire_view> views)
     {
         if (!views.size())
@@ -924,118 +908,120 @@ class wayfire_scale : public wf::plugin_interface_t,
         filter_views(views);
 
         auto workarea = output->workspace->get_workarea();
+        std::vector<wf::geometry_t> geometries;
+        geometries.reserve(views.size());
+        for (auto& view : views)
+        {
+            geometries.push_back(view->get_wm_geometry());
+        }
 
-        auto sorted_rows = view_sort(views);
-        size_t cnt_rows  = sorted_rows.size();
-
-        const double scaled_height = std::max((double)
-            (workarea.height - (cnt_rows + 1) * spacing) / cnt_rows, 1.0);
-        current_row_sizes.clear();
+        auto layout = wf::scale_layout::compute_layout(geometries, workarea, spacing);
+        current_row_sizes = std::move(layout.row_sizes);
 
-        for (size_t i = 0; i < cnt_rows; i++)
+        for (auto& slot : layout.slots)
         {
-            size_t cnt_cols = sorted_rows[i].size();
-            current_row_sizes.push_back(cnt_cols);
-            const double scaled_width = std::max((double)
-                (workarea.width - (cnt_cols + 1) * spacing) / cnt_cols, 1.0);
+            auto view = views[slot.index];
+            const double scaled_width  = slot.width;
+            const double scaled_height = slot.height;
+
+            // Calculate current transformation of the view, in order to
+            // ensure that new views in the view tree start directly at the
+            // correct position
+            double main_view_dx    = 0;
+            double main_view_dy    = 0;
+            double main_view_scale = 1.0;
+            if (scale_data.count(view))
+            {
+                main_view_dx    = scale_data[view].transformer->translation_x;
+                main_view_dy    = scale_data[view].transformer->translation_y;
+                main_view_scale = scale_data[view].transformer->scale_x;
+            }
 
-            for (size_t j = 0; j < cnt_cols; j++)
+            // Calculate target alpha for this view and its children
+            double target_alpha =
+                (view == current_focus_view) ? 1 : (double)inactive_alpha;
+
+            // Helper function to calculate the desired scale for a view
+            const auto& calculate_scale = [=] (wf::dimensions_t vg)
             {
-                double x = workarea.x + spacing + (spacing + scaled_width) * j;
-                double y = workarea.y + spacing + (spacing + scaled_height) * i;
-
-                auto view = sorted_rows[i][j];
-
-                // Calculate current transformation of the view, in order to
-                // ensure that new views in the view tree start directly at the
-                // correct position
-                double main_view_dx    = 0;
-                double main_view_dy    = 0;
-                double main_view_scale = 1.0;
-                if (scale_data.count(view))
+                double w = std::max(1.0, scaled_width);
+                double h = std::max(1.0, scaled_height);
+
+                const double scale = std::min(w / vg.width, h / vg.height);
+                if (!allow_scale_zoom)
                 {
-                    main_view_dx    = scale_data[view].transformer->translation_x;
-                    main_view_dy    = scale_data[view].transformer->translation_y;
-                    main_view_scale = scale_data[view].transformer->scale_x;
+                    return std::min(scale, max_scale_factor);
                 }
 
-                // Calculate target alpha for this view and its children
-                double target_alpha =
-                    (view == current_focus_view) ? 1 : (double)inactive_alpha;
+                return scale;
+            };
 
-                // Helper function to calculate the desired scale for a view
-                const auto& calculate_scale = [=] (wf::dimensions_t vg)
+            add_transformer(view);
+            auto geom = view->get_wm_geometry();
+            double view_scale = calculate_scale({geom.width, geom.height});
+            for (auto& child : view->enumerate_views(false))
+            {
+                // Ensure a transformer for the view, and make sure that
+                // new views in the view tree start off with the correct
+                // attributes set.
+                auto new_child   = add_transformer(child);
+                auto& child_data = scale_data[child];
+                if (new_child)
                 {
-                    double w = std::max(1.0, scaled_width);
-                    double h = std::max(1.0, scaled_height);
-
-                    const double scale = std::min(w / vg.width, h / vg.height);
-                    if (!allow_scale_zoom)
-                    {
-                        return std::min(scale, max_scale_factor);
-                    }
-
-                    return scale;
-                };
-
-                add_transformer(view);
-                auto geom = view->get_wm_geometry();
-                double view_scale = calculate_scale({geom.width, geom.height});
-                for (auto& child : view->enumerate_views(false))
+                    child_data.transformer->translation_x = main_view_dx;
+                    child_data.transformer->translation_y = main_view_dy;
+                    child_data.transformer->scale_x = main_view_scale;
+                    child_data.transformer->scale_y = main_view_scale;
+                }
+
+                if (child_data.visibility ==
+                    view_scale_data::view_visibility_t::HIDDEN)
                 {
-                    // Ensure a transformer for the view, and make sure that
-                    // new views in the view tree start off with the correct
-                    // attributes set.
-                    auto new_child   = add_transformer(child);
-                    auto& child_data = scale_data[child];
-                    if (new_child)
-                    {
-                        child_data.transformer->translation_x = main_view_dx;
-                        child_data.transformer->translation_y = main_view_dy;
-                        child_data.transformer->scale_x = main_view_scale;
-                        child_data.transformer->scale_y = main_view_scale;
-                    }
-
-                    if (child_data.visibility ==
-                        view_scale_data::view_visibility_t::HIDDEN)
-                    {
-                        wf::scene::set_node_enabled(
-                            child->get_transformed_node(), true);
-                    }
-
-                    child_data.visibility =
-                        view_scale_data::view_visibility_t::VISIBLE;
-
-                    child_data.row = i;
-                    child_data.col = j;
-
-                    if (!active)
-                    {
-                        // On exit, we just animate towards normal state
-                        setup_view_transform(child_data, 1, 1, 0, 0, 1);
-                        continue;
-                    }
-
-                    auto vg = child->get_wm_geometry();
-                    wf::pointf_t center = {vg.x + vg.width / 2.0,
-                        vg.y + vg.height / 2.0};
-
-                    // Take padding into account
-                    double scale = calculate_scale({vg.width, vg.height});
-                    // Ensure child is not scaled more than parent
-                    if (!allow_scale_zoom &&
-                        (child != view) &&
-                        (max_scale_child > 0.0))
-                    {
-                        scale = std::min(max_scale_child * view_scale, scale);
-                    }
-
-                    // Target geometry is centered around the center slot
-                    const double dx = x - center.x + scaled_width / 2.0;
-                    const double dy = y - center.y + scaled_height / 2.0;
-                    setup_view_transform(child_data, scale, scale,
-                        dx, dy, target_alpha);
+                    wf::scene::set_node_enabled(
+                        child->get_transformed_node(), true);
                 }
+
+                child_data.visibility =
+                    view_scale_data::view_visibility_t::VISIBLE;
+
+                child_data.row = slot.row;
+                child_data.col = slot.col;
+
+                if (!active)
+                {
+                    // On exit, we just animate towards normal state
+                    setup_view_transform(child_data, 1, 1, 0, 0, 1);
+                    continue;
+                }
+
+                auto vg = child->get_wm_geometry();
+                wf::pointf_t center = {vg.x + vg.width / 2.0,
+                    vg.y + vg.height / 2.0};
+
+                // Take padding into account
+                double scale = calculate_scale({vg.width, vg.height});
+                // Ensure child is not scaled more than parent
+                if (!allow_scale_zoom &&
+                    (child != view) &&
+                    (max_scale_child > 0.0))
+                {
+                    scale = std::min(max_scale_child * view_scale, scale);
+                }
+
+                // Target geometry is centered around the center slot
+                const double dx = slot.x - center.x + scaled_width / 2.0;
+                const double dy = slot.y - center.y + scaled_height / 2.0;
+
+                // Views in rows which did not change keep their animation
+                auto target = std::make_tuple(scale, dx, dy, target_alpha);
+                if (child_data.layout_target == target)
+                {
+                    continue;
+                }
+
+                setup_view_transform(child_data, scale, scale,
+                    dx, dy, target_alpha);
+                child_data.layout_target = target;
             }
         }
 
@@ -1225,12 +1211,6 @@ class wayfire_scale : public wf::plugin_interface_t,
         return false;
     }
 
-    /* Assign transform values to the actual transformer */
-    wf::effect_hook_t pre_hook = [=] ()
-    {
-        transform_views();
-    };
-
     /* Keep rendering until all animation has finished */
     wf::effect_hook_t post_hook = [=] ()
     {
@@ -1415,7 +1395,6 @@ class wayfire_scale : public wf::plugin_interface_t,
         }
 
         output->render->add_effect(&post_hook, wf::OUTPUT_EFFECT_POST);
-        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
         output->render->schedule_redraw();
         hook_set = true;
     }
@@ -1429,10 +1408,31 @@ class wayfire_scale : public wf::plugin_interface_t,
         }
 
         output->render->rem_effect(&post_hook);
-        output->render->rem_effect(&pre_hook);
+        wf::animation_scheduler_t::get(output).remove(this);
+        transform_scheduled = false;
         hook_set = false;
     }
 
+    /**
+     * Assign the transform values to the transformers before each frame, for
+     * as long as a view is animating.
+     */
+    void schedule_transform()
+    {
+        if (transform_scheduled)
+        {
+            return;
+        }
+
+        transform_scheduled = true;
+        wf::animation_scheduler_t::get(output).add(this, "scale", [=] ()
+        {
+            transform_views();
+            transform_scheduled = animation_running();
+            return transform_scheduled;
+        });
+    }
+
     void fini() override
     {
         finalize();
@@ -27,6 +27,7 @@
 #include <wayfire/opengl.hpp>
 #include <wayfire/util/duration.hpp>
 #include <wayfire/render-manager.hpp>
+#include <wayfire/plugins/common/lazy-init.hpp>
 
 static const char *vertex_shader =
     R"(
@@ -107,6 +108,7 @@ class wayfire_fisheye : public wf::plugin_interface_t
     wf::option_wrapper_t<double> zoom{"fisheye/zoom"};
 
     OpenGL::program_t program;
+    wf::lazy_init_t lazy_init;
 
   public:
     void init() override
@@ -128,10 +130,13 @@ class wayfire_fisheye : public wf::plugin_interface_t
             }
         });
 
-        OpenGL::render_begin();
-        program.set_simple(
-            OpenGL::compile_program(vertex_shader, fragment_shader));
-        OpenGL::render_end();
+        lazy_init.set_setup([=] ()
+        {
+            OpenGL::render_begin();
+            program.set_simple(
+                OpenGL::compile_program(vertex_shader, fragment_shader));
+            OpenGL::render_end();
+        });
     }
 
     wf::activator_callback toggle_cb = [=] (auto)
@@ -141,6 +146,7 @@ class wayfire_fisheye : public wf::plugin_interface_t
             return false;
         }
 
+        lazy_init.ensure();
         if (active)
         {
             active = false;
@@ -2,6 +2,7 @@
 #include <wayfire/output.hpp>
 #include <wayfire/opengl.hpp>
 #include <wayfire/render-manager.hpp>
+#include <wayfire/plugins/common/lazy-init.hpp>
 
 static const char *vertex_shader =
     R"(
@@ -50,6 +51,7 @@ class wayfire_invert_screen : public wf::plugin_interface_t
 
     bool active = false;
     OpenGL::program_t program;
+    wf::lazy_init_t lazy_init;
 
   public:
     void init() override
@@ -72,6 +74,7 @@ class wayfire_invert_screen : public wf::plugin_interface_t
                 return false;
             }
 
+            lazy_init.ensure();
             if (active)
             {
                 output->render->rem_post(&hook);
@@ -85,10 +88,13 @@ class wayfire_invert_screen : public wf::plugin_interface_t
             return true;
         };
 
-        OpenGL::render_begin();
-        program.set_simple(
-            OpenGL::compile_program(vertex_shader, fragment_shader));
-        OpenGL::render_end();
+        lazy_init.set_setup([=] ()
+        {
+            OpenGL::render_begin();
+            program.set_simple(
+                OpenGL::compile_program(vertex_shader, fragment_shader));
+            OpenGL::render_end();
+        });
 
         output->add_activator(toggle_key, &toggle_cb);
     }
@@ -565,8 +565,9 @@ class WayfireSwitcher : public wf::plugin_interface_t
                     "switcher-minimized-showed");
             }
 
-            view->get_transformed_node()->add_transformer(
-                std::make_shared<wf::scene::view_3d_transformer_t>(view),
+            auto tr = std::make_shared<wf::scene::view_3d_transformer_t>(view);
+            tr->use_thumbnail = true;
+            view->get_transformed_node()->add_transformer(tr,
                 wf::TRANSFORMER_3D, switcher_transformer);
         }
 
@@ -109,6 +109,7 @@ class tile_plugin_t : public wf::plugin_interface_t
     {
         auto output_geometry = output->get_relative_geometry();
         auto wsize = output->workspace->get_workspace_grid_size();
+        tile::geometry_batch_t batch;
         for (int i = 0; i < wsize.width; i++)
         {
             for (int j = 0; j < wsize.height; j++)
@@ -132,6 +133,7 @@ class tile_plugin_t : public wf::plugin_interface_t
             .internal = inner_gaps,
         };
 
+        tile::geometry_batch_t batch;
         for (auto& col : roots)
         {
             for (auto& root : col)
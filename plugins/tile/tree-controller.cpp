@@ -318,6 +318,7 @@ void move_view_controller_t::input_released()
 
         std::swap(*it1, *it2);
 
+        geometry_batch_t batch;
         p1->set_geometry(p1->geometry);
         p2->set_geometry(p2->geometry);
         return;
@@ -537,6 +538,8 @@ void resize_view_controller_t::input_motion(wf::point_t input)
         return;
     }
 
+    /* Both pairs may contain the grabbed view, configure it only once */
+    geometry_batch_t batch;
     if (horizontal_pair.first && horizontal_pair.second)
     {
         int dy = input.y - last_point.y;
@@ -0,0 +1,83 @@
+#ifndef WF_TILE_PLUGIN_TREE_LAYOUT
+#define WF_TILE_PLUGIN_TREE_LAYOUT
+
+#include <wayfire/geometry.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace wf
+{
+namespace tile
+{
+/**
+ * A node which contains a split can be split either horizontally or vertically
+ */
+enum split_direction_t
+{
+    SPLIT_HORIZONTAL = 0,
+    SPLIT_VERTICAL   = 1,
+};
+
+/**
+ * @return The size of the geometry in the dimension in which the split
+ * happens.
+ */
+inline int32_t get_splittable_size(wf::geometry_t geometry,
+    split_direction_t direction)
+{
+    return (direction == SPLIT_HORIZONTAL) ? geometry.height : geometry.width;
+}
+
+/**
+ * Divide the available geometry of a split between its children, so that each
+ * child keeps its share of the total size.
+ *
+ * This only computes geometries and does not depend on views, so that the
+ * whole tree can be laid out before any view is changed.
+ *
+ * @param available The geometry of the split node.
+ * @param direction The direction of the split.
+ * @param children The children geometries. On input, only their size in the
+ *   split direction is used. On output, they contain the new geometries.
+ */
+inline void layout_split(wf::geometry_t available, split_direction_t direction,
+    std::vector<wf::geometry_t>& children)
+{
+    double old_child_sum = 0.0;
+    for (auto& child : children)
+    {
+        old_child_sum += get_splittable_size(child, direction);
+    }
+
+    int32_t total_splittable = get_splittable_size(available, direction);
+    auto progress = [=] (double current)
+    {
+        return (current / old_child_sum) * total_splittable;
+    };
+
+    /* Sum of children sizes up to now */
+    double up_to_now = 0.0;
+    for (auto& child : children)
+    {
+        /* Calculate child_start/end every time using the percentage from the
+         * beginning. This way we avoid rounding errors causing empty spaces */
+        int32_t child_start = progress(up_to_now);
+        up_to_now += get_splittable_size(child, direction);
+        int32_t child_end = progress(up_to_now);
+
+        child = available;
+        if (direction == SPLIT_HORIZONTAL)
+        {
+            child.y += child_start;
+            child.height = child_end - child_start;
+        } else
+        {
+            child.x    += child_start;
+            child.width = child_end - child_start;
+        }
+    }
+}
+}
+}
+
+#endif /* end of include guard: WF_TILE_PLUGIN_TREE_LAYOUT */
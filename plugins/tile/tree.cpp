@@ -68,23 +68,9 @@ wf::geometry_t split_node_t::get_child_geometry(
     return child_geometry;
 }
 
-int32_t split_node_t::calculate_splittable(wf::geometry_t available) const
-{
-    switch (get_split_direction())
-    {
-      case SPLIT_HORIZONTAL:
-        return available.height;
-
-      case SPLIT_VERTICAL:
-        return available.width;
-    }
-
-    return -1;
-}
-
 int32_t split_node_t::calculate_splittable() const
 {
-    return calculate_splittable(this->geometry);
+    return get_splittable_size(this->geometry, get_split_direction());
 }
 
 void split_node_t::recalculate_children(wf::geometry_t available)
@@ -94,36 +80,21 @@ void split_node_t::recalculate_children(wf::geometry_t available)
         return;
     }
 
-    double old_child_sum = 0.0;
+    std::vector<wf::geometry_t> layout;
+    layout.reserve(this->children.size());
     for (auto& child : this->children)
     {
-        old_child_sum += calculate_splittable(child->geometry);
+        layout.push_back(child->geometry);
     }
 
-    int32_t total_splittable = calculate_splittable(available);
-
-    /* Sum of children sizes up to now */
-    double up_to_now = 0.0;
-
-    auto progress = [=] (double current)
-    {
-        return (current / old_child_sum) * total_splittable;
-    };
-
+    layout_split(available, get_split_direction(), layout);
     set_gaps(this->gaps);
 
-    /* For each child, assign its percentage of the whole. */
-    for (auto& child : this->children)
+    /* The views are updated once the whole subtree is laid out */
+    geometry_batch_t batch;
+    for (size_t i = 0; i < this->children.size(); i++)
     {
-        /* Calculate child_start/end every time using the percentage from the
-         * beginning. This way we avoid rounding errors causing empty spaces */
-        int32_t child_start = progress(up_to_now);
-        up_to_now += calculate_splittable(child->geometry);
-        int32_t child_end = progress(up_to_now);
-
-        /* Set new size */
-        int32_t child_size = child_end - child_start;
-        child->set_geometry(get_child_geometry(child_start, child_size));
+        this->children[i]->set_geometry(layout[i]);
     }
 }
 
@@ -163,6 +134,7 @@ void split_node_t::add_child(std::unique_ptr<tree_node_t> child, int index)
     set_gaps(this->gaps);
 
     /* Recalculate geometry */
+    geometry_batch_t batch;
     recalculate_children(geometry);
 }
 
@@ -186,6 +158,7 @@ std::unique_ptr<tree_node_t> split_node_t::remove_child(
     }
 
     /* Remaining children have the full geometry */
+    geometry_batch_t batch;
     recalculate_children(this->geometry);
     result->parent = nullptr;
 
@@ -194,6 +167,7 @@ std::unique_ptr<tree_node_t> split_node_t::remove_child(
 
 void split_node_t::set_geometry(wf::geometry_t geometry)
 {
+    geometry_batch_t batch;
     tree_node_t::set_geometry(geometry);
     recalculate_children(geometry);
 }
@@ -249,6 +223,52 @@ split_node_t::split_node_t(split_direction_t dir)
     this->geometry = {0, 0, 0, 0};
 }
 
+/* ------------------ geometry_batch_t implementation ----------------------- */
+int geometry_batch_t::depth = 0;
+std::deque<nonstd::observer_ptr<view_node_t>> geometry_batch_t::pending;
+
+geometry_batch_t::geometry_batch_t()
+{
+    ++depth;
+}
+
+geometry_batch_t::~geometry_batch_t()
+{
+    if (--depth > 0)
+    {
+        return;
+    }
+
+    /* Applying geometry emits signals, whose handlers may destroy other
+     * pending nodes. Take the nodes one by one, so that cancel() still removes
+     * them from the list. */
+    while (!pending.empty())
+    {
+        auto node = pending.front();
+        pending.pop_front();
+        node->apply_geometry();
+    }
+}
+
+void geometry_batch_t::schedule(nonstd::observer_ptr<view_node_t> node)
+{
+    if (std::find(pending.begin(), pending.end(), node) == pending.end())
+    {
+        pending.push_back(node);
+    }
+}
+
+void geometry_batch_t::cancel(nonstd::observer_ptr<view_node_t> node)
+{
+    auto it = std::remove(pending.begin(), pending.end(), node);
+    pending.erase(it, pending.end());
+}
+
+bool geometry_batch_t::is_active()
+{
+    return depth > 0;
+}
+
 /* -------------------- view_node_t implementation -------------------------- */
 struct view_node_custom_data_t : public custom_data_t
 {
@@ -336,7 +356,7 @@ view_node_t::view_node_t(wayfire_view view)
     });
     this->on_decoration_changed.set_callback([=] (wf::signal_data_t*)
     {
-        set_geometry(geometry);
+        apply_geometry(true);
     });
     view->connect_signal("geometry-changed", &on_geometry_changed);
     view->connect_signal("decoration-changed", &on_decoration_changed);
@@ -345,6 +365,7 @@ view_node_t::view_node_t(wayfire_view view)
 
 view_node_t::~view_node_t()
 {
+    geometry_batch_t::cancel({this});
     view->get_transformed_node()->rem_transformer(scale_transformer_name);
     view->erase_data<view_node_custom_data_t>();
 }
@@ -438,15 +459,37 @@ static nonstd::observer_ptr<wf::grid::grid_animation_t> ensure_animation(
 void view_node_t::set_geometry(wf::geometry_t geometry)
 {
     tree_node_t::set_geometry(geometry);
+    if (geometry_batch_t::is_active())
+    {
+        geometry_batch_t::schedule({this});
+    } else
+    {
+        apply_geometry();
+    }
+}
 
+void view_node_t::apply_geometry(bool force)
+{
     if (!view->is_mapped())
     {
         return;
     }
 
-    view->set_tiled(TILED_EDGES_ALL);
+    if (view->tiled_edges != TILED_EDGES_ALL)
+    {
+        view->set_tiled(TILED_EDGES_ALL);
+    }
 
     auto target = calculate_target_geometry();
+    bool animating = view->has_data<wf::grid::grid_animation_t>();
+    if (!force && (target == applied_target) &&
+        (animating || (target == view->get_wm_geometry())))
+    {
+        /* Nothing changed for this view, avoid configuring it again */
+        return;
+    }
+
+    applied_target = target;
     if (this->needs_crossfade() && (target != view->get_wm_geometry()))
     {
         view->get_transformed_node()->rem_transformer(scale_transformer_name);
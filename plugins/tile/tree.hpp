@@ -2,7 +2,10 @@
 #define WF_TILE_PLUGIN_TREE
 
 #include <wayfire/view.hpp>
+#include <deque>
+#include <optional>
 #include <wayfire/option-wrapper.hpp>
+#include "tree-layout.hpp"
 
 namespace wf
 {
@@ -63,15 +66,6 @@ struct tree_node_t
     gap_size_t gaps;
 };
 
-/**
- * A node which contains a split can be split either horizontally or vertically
- */
-enum split_direction_t
-{
-    SPLIT_HORIZONTAL = 0,
-    SPLIT_VERTICAL   = 1,
-};
-
 /*
  * Represents a node in the tree which contains at 1 one child node
  */
@@ -133,9 +127,40 @@ struct split_node_t : public tree_node_t
 
     /** Return the size of the node in the dimension in which the split happens */
     int32_t calculate_splittable() const;
-    /** Return the size of the geometry in the dimension in which the split
-     * happens */
-    int32_t calculate_splittable(wf::geometry_t geometry) const;
+};
+
+/**
+ * While a geometry batch exists, changing the geometry of view nodes only
+ * updates the tree. The views themselves are updated when the outermost batch
+ * is destroyed, and only if their target geometry actually changed.
+ *
+ * This way, a change to a split is first laid out in the whole subtree, and
+ * then each affected view is configured exactly once.
+ *
+ * The operations of split_node_t create a batch themselves, so an explicit
+ * batch is needed only to group several operations together.
+ */
+class geometry_batch_t
+{
+  public:
+    geometry_batch_t();
+    ~geometry_batch_t();
+
+    geometry_batch_t(const geometry_batch_t&) = delete;
+    geometry_batch_t(geometry_batch_t&&) = delete;
+    geometry_batch_t& operator =(const geometry_batch_t&) = delete;
+    geometry_batch_t& operator =(geometry_batch_t&&) = delete;
+
+    /** Update the view of the node when the outermost batch ends */
+    static void schedule(nonstd::observer_ptr<view_node_t> node);
+    /** Forget about the node, for ex. because it is being destroyed */
+    static void cancel(nonstd::observer_ptr<view_node_t> node);
+    /** @return Whether there is a batch currently */
+    static bool is_active();
+
+  private:
+    static int depth;
+    static std::deque<nonstd::observer_ptr<view_node_t>> pending;
 };
 
 /**
@@ -165,7 +190,17 @@ struct view_node_t : public tree_node_t
     /* Return the tree node corresponding to the view, or nullptr if none */
     static nonstd::observer_ptr<view_node_t> get_node(wayfire_view view);
 
+    /**
+     * Move the view to the geometry of the node.
+     *
+     * @param force Also configure the view if its target geometry is the same
+     *   as the last time.
+     */
+    void apply_geometry(bool force = false);
+
   private:
+    /* The target geometry the view was last configured with */
+    std::optional<wf::geometry_t> applied_target;
     struct scale_transformer_t;
     nonstd::observer_ptr<scale_transformer_t> transformer;
     signal_connection_t on_geometry_changed, on_decoration_changed;
@@ -0,0 +1,66 @@
+#include "view-access-cache.hpp"
+#include "wayfire/signal-definitions.hpp"
+
+namespace wf
+{
+cached_view_access_interface_t::cached_view_access_interface_t()
+{
+    _on_fields_changed = [=] (wf::signal_data_t *data)
+    {
+        auto it = _cache.find(get_signaled_view(data).get());
+        if (it != _cache.end())
+        {
+            it->second = cached_fields_t{};
+        }
+    };
+}
+
+cached_view_access_interface_t::~cached_view_access_interface_t()
+{}
+
+void cached_view_access_interface_t::set_view(wayfire_view view)
+{
+    _view = view;
+    view_access_interface_t::set_view(view);
+}
+
+void cached_view_access_interface_t::forget_view(wayfire_view view)
+{
+    if (_cache.erase(view.get()))
+    {
+        view->disconnect_signal(&_on_fields_changed);
+    }
+}
+
+variant_t cached_view_access_interface_t::get(const std::string & identifier,
+    bool & error)
+{
+    if ((_view == nullptr) || ((identifier != "app_id") && (identifier != "title")))
+    {
+        return view_access_interface_t::get(identifier, error);
+    }
+
+    auto it = _cache.find(_view.get());
+    if (it == _cache.end())
+    {
+        it = _cache.emplace(_view.get(), cached_fields_t{}).first;
+        _view->connect_signal("title-changed", &_on_fields_changed);
+        _view->connect_signal("app-id-changed", &_on_fields_changed);
+    }
+
+    auto& field = (identifier == "app_id") ? it->second.app_id : it->second.title;
+    if (!field)
+    {
+        field = view_access_interface_t::get(identifier, error);
+        if (error)
+        {
+            auto result = *field;
+            field.reset();
+            return result;
+        }
+    }
+
+    error = false;
+    return *field;
+}
+} // End namespace wf.
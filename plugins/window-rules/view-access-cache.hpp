@@ -0,0 +1,59 @@
+#ifndef VIEW_ACCESS_CACHE_HPP
+#define VIEW_ACCESS_CACHE_HPP
+
+#include "wayfire/view-access-interface.hpp"
+#include "wayfire/object.hpp"
+#include "wayfire/view.hpp"
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace wf
+{
+/**
+ * A view_access_interface_t which remembers the app_id and title of each view
+ * until they change. All rules for a signal are evaluated with the same view,
+ * so the strings are built once instead of once per rule.
+ */
+class cached_view_access_interface_t : public view_access_interface_t
+{
+  public:
+    cached_view_access_interface_t();
+    virtual ~cached_view_access_interface_t() override;
+
+    // Inherits docs.
+    virtual variant_t get(const std::string & identifier, bool & error) override;
+
+    /**
+     * @brief set_view Setter for the view to interrogate.
+     *
+     * @param[in] view The view to assign.
+     */
+    void set_view(wayfire_view view);
+
+    /**
+     * @brief forget_view Drop the cached values of a view and stop tracking it.
+     *
+     * @param[in] view The view to forget.
+     */
+    void forget_view(wayfire_view view);
+
+  private:
+    struct cached_fields_t
+    {
+        std::optional<variant_t> app_id;
+        std::optional<variant_t> title;
+    };
+
+    wayfire_view _view;
+    std::unordered_map<view_interface_t*, cached_fields_t> _cache;
+
+    /**
+     * @brief _on_fields_changed Invalidates the cache of a view whose title or
+     * app_id changed.
+     */
+    wf::signal_connection_t _on_fields_changed;
+};
+} // End namespace wf.
+
+#endif // VIEW_ACCESS_CACHE_HPP
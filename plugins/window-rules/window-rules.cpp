@@ -1,6 +1,8 @@
 #include <algorithm>
 #include <cfloat>
+#include <map>
 #include <memory>
+#include <sstream>
 #include <vector>
 
 #include <wayfire/plugin.hpp>
@@ -17,6 +19,7 @@
 
 #include "lambda-rules-registration.hpp"
 #include "view-action-interface.hpp"
+#include "view-access-cache.hpp"
 
 class wayfire_window_rules_t : public wf::plugin_interface_t
 {
@@ -27,6 +30,8 @@ class wayfire_window_rules_t : public wf::plugin_interface_t
 
   private:
     void setup_rules_from_config();
+    const std::vector<std::shared_ptr<wf::rule_t>>& get_rules_for(
+        const std::string & signal) const;
     wf::lexer_t _lexer;
 
     // Created rule handler.
@@ -59,15 +64,30 @@ class wayfire_window_rules_t : public wf::plugin_interface_t
         apply("fullscreened", data);
     };
 
+    // Drop cached view properties once the view is gone from this output.
+    wf::signal_connection_t _disappeared = [=] (wf::signal_data_t *data)
+    {
+        _access_interface.forget_view(get_signaled_view(data));
+    };
+
     // Auto-reload on changes to config file
-    wf::signal_connection_t _reload_config = [=] (wf::signal_data_t*)
+    wf::signal_connection_t _reload_config = [=] (wf::signal_data_t *data)
     {
+        if (!wf::config_section_changed(data, "window-rules"))
+        {
+            return;
+        }
+
         setup_rules_from_config();
     };
 
-    std::vector<std::shared_ptr<wf::rule_t>> _rules;
+    // Rules grouped by the signal they react to, in config order. Rules whose
+    // signal could not be determined are part of every group, and of
+    // _rules_any_signal.
+    std::map<std::string, std::vector<std::shared_ptr<wf::rule_t>>> _rules_by_signal;
+    std::vector<std::shared_ptr<wf::rule_t>> _rules_any_signal;
 
-    wf::view_access_interface_t _access_interface;
+    wf::cached_view_access_interface_t _access_interface;
     wf::view_action_interface_t _action_interface;
 
     nonstd::observer_ptr<wf::lambda_rules_registrations_t> _lambda_registrations;
@@ -86,6 +106,7 @@ void wayfire_window_rules_t::init()
     output->connect_signal("view-tiled", &_unmaximized);
     output->connect_signal("view-minimized", &_minimized);
     output->connect_signal("view-fullscreen", &_fullscreened);
+    output->connect_signal("view-disappeared", &_disappeared);
     wf::get_core().connect_signal("reload-config", &_reload_config);
 }
 
@@ -124,10 +145,10 @@ void wayfire_window_rules_t::apply(const std::string & signal,
         return;
     }
 
-    for (const auto & rule : _rules)
+    _access_interface.set_view(view);
+    _action_interface.set_view(view);
+    for (const auto & rule : get_rules_for(signal))
     {
-        _access_interface.set_view(view);
-        _action_interface.set_view(view);
         auto error = rule->apply(signal, _access_interface, _action_interface);
         if (error)
         {
@@ -190,21 +211,73 @@ void wayfire_window_rules_t::apply(const std::string & signal,
     }
 }
 
+/**
+ * Rules have the form "on <signal> if ...". Find out the signal without
+ * evaluating the rule, so that rules can be grouped by signal.
+ *
+ * @return The signal, or an empty string if the rule has an unexpected form.
+ */
+static std::string get_rule_signal(const std::string & rule_text)
+{
+    std::istringstream stream(rule_text);
+    std::string on, signal;
+    if ((stream >> on >> signal) && (on == "on"))
+    {
+        return signal;
+    }
+
+    return "";
+}
+
+const std::vector<std::shared_ptr<wf::rule_t>>& wayfire_window_rules_t::get_rules_for(
+    const std::string & signal) const
+{
+    auto it = _rules_by_signal.find(signal);
+    if (it != _rules_by_signal.end())
+    {
+        return it->second;
+    }
+
+    return _rules_any_signal;
+}
+
 void wayfire_window_rules_t::setup_rules_from_config()
 {
-    _rules.clear();
+    _rules_by_signal.clear();
+    _rules_any_signal.clear();
 
     // Build rule list.
+    std::vector<std::pair<std::string, std::shared_ptr<wf::rule_t>>> rules;
     auto section = wf::get_core().config.get_section("window-rules");
     for (auto opt : section->get_registered_options())
     {
-        _lexer.reset(opt->get_value_str());
+        auto text = opt->get_value_str();
+        _lexer.reset(text);
         auto rule = wf::rule_parser_t().parse(_lexer);
         if (rule != nullptr)
         {
-            _rules.push_back(rule);
+            rules.emplace_back(get_rule_signal(text), rule);
+            _rules_by_signal[rules.back().first];
+        }
+    }
+
+    // Group the rules by signal, keeping the order from the config file.
+    for (auto& [signal, rule] : rules)
+    {
+        if (!signal.empty())
+        {
+            _rules_by_signal[signal].push_back(rule);
+            continue;
+        }
+
+        _rules_any_signal.push_back(rule);
+        for (auto& [_, group] : _rules_by_signal)
+        {
+            group.push_back(rule);
         }
     }
+
+    _rules_by_signal.erase("");
 }
 
 DECLARE_WAYFIRE_PLUGIN(wayfire_window_rules_t);
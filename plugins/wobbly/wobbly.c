@@ -40,44 +40,41 @@
 #define GRID_WIDTH  4
 #define GRID_HEIGHT 4
 
-#define MODEL_MAX_SPRINGS (GRID_WIDTH * GRID_HEIGHT * 2)
+#define MODEL_NUM_OBJECTS (GRID_WIDTH * GRID_HEIGHT)
+
+/*
+ * Positions are stored with an extra row before and after the grid, so that
+ * the neighbours of every object can be read without bounds checks. The
+ * padding is never written and its contribution is always masked out.
+ */
+#define POS(i) ((i) + GRID_WIDTH)
+#define MODEL_POS_SIZE (MODEL_NUM_OBJECTS + 2 * GRID_WIDTH)
+
+/* Bernstein coefficient tables cached for different mesh resolutions */
+#define MAX_BERNSTEIN_TABLES 4
 
 typedef struct _xy_pair {
     float x, y;
 } Point, Vector;
 
-typedef struct _Edge {
-    float next, prev;
-
-    float start;
-    float end;
-
-    float attract;
-    float velocity;
-} Edge;
-
-typedef struct _Object {
-    Vector	 force;
-    Point	 position;
-    Vector	 velocity;
-    float	 theta;
-    int		 immobile;
-    Edge	 vertEdge;
-    Edge	 horzEdge;
-} Object;
-
-typedef struct _Spring {
-    Object *a;
-    Object *b;
-    Vector offset;
-} Spring;
-
+/*
+ * The objects of the model in a structure-of-arrays layout, so that the
+ * simulation step can be vectorized by the compiler.
+ *
+ * Springs connect each object to its right and bottom neighbour. Their rest
+ * lengths are the same for all horizontal and for all vertical springs, so
+ * they are not stored separately.
+ */
 typedef struct _Model {
-    Object	 *objects;
+    float	 positionX[MODEL_POS_SIZE];
+    float	 positionY[MODEL_POS_SIZE];
+    float	 velocityX[MODEL_NUM_OBJECTS];
+    float	 velocityY[MODEL_NUM_OBJECTS];
+    int		 immobile[MODEL_NUM_OBJECTS];
     int		 numObjects;
-    Spring	 springs[MODEL_MAX_SPRINGS];
-    int		 numSprings;
-    Object	 *anchorObject;
+    float	 springOffsetX;
+    float	 springOffsetY;
+    int		 anchorObject;
     float	 steps;
     Point	 topLeft;
     Point	 bottomRight;
@@ -93,36 +90,31 @@ typedef struct _WobblyWindow {
     unsigned int  state;
 } WobblyWindow;
 
+/* The cubic Bernstein polynomials evaluated at cells + 1 points in [0, 1] */
+typedef struct _BernsteinTable {
+    int   cells;
+    float *coeffs;
+} BernsteinTable;
+
+static BernsteinTable bernsteinTables[MAX_BERNSTEIN_TABLES];
+static int nextBernsteinTable;
+
 #define WobblyInitial  (1L << 0)
 #define WobblyForce    (1L << 1)
 #define WobblyVelocity (1L << 2)
 
-static void objectInit(Object *object, float positionX, float positionY,
+#define NO_OBJECT (-1)
+
+static void objectInit(Model *model, int i, float positionX, float positionY,
         float velocityX, float velocityY)
 {
-    object->force.x = 0;
-    object->force.y = 0;
+    model->positionX[POS(i)] = positionX;
+    model->positionY[POS(i)] = positionY;
 
-    object->position.x = positionX;
-    object->position.y = positionY;
-
-    object->velocity.x = velocityX;
-    object->velocity.y = velocityY;
-
-    object->theta    = 0;
-    object->immobile = 0;
-
-    object->vertEdge.next = 0.0f;
-    object->horzEdge.next = 0.0f;
-}
+    model->velocityX[i] = velocityX;
+    model->velocityY[i] = velocityY;
 
-static void springInit(Spring *spring, Object *a, Object *b,
-	    float offsetX, float offsetY)
-{
-    spring->a	     = a;
-    spring->b	     = b;
-    spring->offset.x = offsetX;
-    spring->offset.y = offsetY;
+    model->immobile[i] = 0;
 }
 
 static void modelCalcBounds(Model *model)
@@ -136,29 +128,15 @@ static void modelCalcBounds(Model *model)
 
     for (i = 0; i < model->numObjects; i++)
     {
-        if (model->objects[i].position.x < model->topLeft.x)
-            model->topLeft.x = model->objects[i].position.x;
-        else if (model->objects[i].position.x > model->bottomRight.x)
-            model->bottomRight.x = model->objects[i].position.x;
-
-        if (model->objects[i].position.y < model->topLeft.y)
-            model->topLeft.y = model->objects[i].position.y;
-        else if (model->objects[i].position.y > model->bottomRight.y)
-            model->bottomRight.y = model->objects[i].position.y;
+        model->topLeft.x = fminf(model->topLeft.x, model->positionX[POS(i)]);
+        model->topLeft.y = fminf(model->topLeft.y, model->positionY[POS(i)]);
+        model->bottomRight.x =
+            fmaxf(model->bottomRight.x, model->positionX[POS(i)]);
+        model->bottomRight.y =
+            fmaxf(model->bottomRight.y, model->positionY[POS(i)]);
     }
 }
 
-static void modelAddSpring(Model *model, Object *a, Object *b,
-		float offsetX, float offsetY)
-{
-    Spring *spring;
-
-    spring = &model->springs[model->numSprings];
-    model->numSprings++;
-
-    springInit (spring, a, b, offsetX, offsetY);
-}
-
 static void modelSetMiddleAnchor(Model *model, int x, int y,
         int width, int height)
 {
@@ -167,15 +145,14 @@ static void modelSetMiddleAnchor(Model *model, int x, int y,
     gx = ((GRID_WIDTH  - 1) / 2 * width)  / (float) (GRID_WIDTH  - 1);
     gy = ((GRID_HEIGHT - 1) / 2 * height) / (float) (GRID_HEIGHT - 1);
 
-    if (model->anchorObject)
-        model->anchorObject->immobile = 0;
+    if (model->anchorObject != NO_OBJECT)
+        model->immobile[model->anchorObject] = 0;
 
-    model->anchorObject =
-        &model->objects[GRID_WIDTH * ((GRID_HEIGHT-1)/2) + (GRID_WIDTH-1)/ 2];
-    model->anchorObject->position.x = x + gx;
-    model->anchorObject->position.y = y + gy;
+    model->anchorObject = GRID_WIDTH * ((GRID_HEIGHT-1)/2) + (GRID_WIDTH-1)/ 2;
+    model->positionX[POS(model->anchorObject)] = x + gx;
+    model->positionY[POS(model->anchorObject)] = y + gy;
 
-    model->anchorObject->immobile = 1;
+    model->immobile[model->anchorObject] = 1;
 }
 
 static void modelSetTopAnchor(Model *model, int x, int y,
@@ -185,14 +162,14 @@ static void modelSetTopAnchor(Model *model, int x, int y,
 
     gx = ((GRID_WIDTH  - 1) / 2 * width)  / (float) (GRID_WIDTH  - 1);
 
-    if (model->anchorObject)
-	model->anchorObject->immobile = 0;
+    if (model->anchorObject != NO_OBJECT)
+	model->immobile[model->anchorObject] = 0;
 
-    model->anchorObject = &model->objects[(GRID_WIDTH-1)/ 2];
-    model->anchorObject->position.x = x + gx;
-    model->anchorObject->position.y = y;
+    model->anchorObject = (GRID_WIDTH-1)/ 2;
+    model->positionX[POS(model->anchorObject)] = x + gx;
+    model->positionY[POS(model->anchorObject)] = y;
 
-    model->anchorObject->immobile = 1;
+    model->immobile[model->anchorObject] = 1;
 }
 
 static void modelInitObjects(Model *model, int x, int y, int width, int height)
@@ -207,7 +184,7 @@ static void modelInitObjects(Model *model, int x, int y, int width, int height)
     {
         for (gridX = 0; gridX < GRID_WIDTH; gridX++)
         {
-            objectInit (&model->objects[i],
+            objectInit (model, i,
                     x + (gridX * width) / gw,
                     y + (gridY * height) / gh,
                     0, 0);
@@ -215,59 +192,27 @@ static void modelInitObjects(Model *model, int x, int y, int width, int height)
         }
     }
 
-    if (!model->anchorObject)
+    if (model->anchorObject == NO_OBJECT)
         modelSetMiddleAnchor (model, x, y, width, height);
 }
 
 static void modelInitSprings(Model *model, int width, int height)
 {
-    int   gridX, gridY, i = 0;
-    float hpad, vpad;
-
-    model->numSprings = 0;
-
-    hpad = ((float) width) / (GRID_WIDTH  - 1);
-    vpad = ((float) height) / (GRID_HEIGHT - 1);
-
-    for (gridY = 0; gridY < GRID_HEIGHT; gridY++)
-    {
-        for (gridX = 0; gridX < GRID_WIDTH; gridX++)
-        {
-            if (gridX > 0)
-            {
-                modelAddSpring (model, &model->objects[i - 1],
-                        &model->objects[i], hpad, 0);
-            }
-
-            if (gridY > 0)
-            {
-                modelAddSpring (model, &model->objects[i - GRID_WIDTH],
-                        &model->objects[i], 0, vpad);
-            }
-
-            i++;
-        }
-    }
+    model->springOffsetX = ((float) width) / (GRID_WIDTH  - 1);
+    model->springOffsetY = ((float) height) / (GRID_HEIGHT - 1);
 }
 
 static Model * createModel(int x, int y, int width, int height)
 {
     Model *model;
 
-    model = malloc(sizeof(Model));
+    /* calloc, so that the position padding is zero */
+    model = calloc(1, sizeof(Model));
     if (!model)
         return 0;
 
-    model->numObjects = GRID_WIDTH * GRID_HEIGHT;
-    model->objects = malloc (sizeof (Object) * model->numObjects);
-    if (!model->objects)
-    {
-        free (model);
-        return 0;
-    }
-
-    model->anchorObject = 0;
-    model->numSprings = 0;
+    model->numObjects = MODEL_NUM_OBJECTS;
+    model->anchorObject = NO_OBJECT;
     model->steps = 0;
 
     modelInitObjects (model, x, y, width, height);
@@ -277,69 +222,85 @@ static Model * createModel(int x, int y, int width, int height)
     return model;
 }
 
-static void objectApplyForce(Object *object, float fx, float fy)
-{
-    object->force.x += fx;
-    object->force.y += fy;
-}
-
-static void springExertForces(Spring *spring, float k)
-{
-    Vector da, db;
-    Vector a, b;
-
-    a = spring->a->position;
-    b = spring->b->position;
-
-    da.x = 0.5f * (b.x - a.x - spring->offset.x);
-    da.y = 0.5f * (b.y - a.y - spring->offset.y);
-
-    db.x = 0.5f * (a.x - b.x + spring->offset.x);
-    db.y = 0.5f * (a.y - b.y + spring->offset.y);
+/*
+ * Calculate the force which the springs exert on each object.
+ *
+ * Each spring pulls both of its ends towards its rest length, with half of
+ * the force on each of them. Springs which would connect to the padding
+ * around the grid do not exist and are masked out.
+ */
+static void modelSpringForces(const Model *model, float k,
+        float *restrict forceX, float *restrict forceY)
+{
+    const float *restrict px = model->positionX;
+    const float *restrict py = model->positionY;
+    const float ox = model->springOffsetX;
+    const float oy = model->springOffsetY;
+    const float hk = 0.5f * k;
+    int i;
 
-    objectApplyForce (spring->a, k * da.x, k * da.y);
-    objectApplyForce (spring->b, k * db.x, k * db.y);
+    for (i = 0; i < MODEL_NUM_OBJECTS; i++)
+    {
+        const int p = POS(i);
+        const float left  = (i % GRID_WIDTH) > 0;
+        const float right = (i % GRID_WIDTH) < GRID_WIDTH - 1;
+        const float up    = i >= GRID_WIDTH;
+        const float down  = i < MODEL_NUM_OBJECTS - GRID_WIDTH;
+
+        forceX[i] = hk * (right * (px[p + 1] - px[p] - ox) +
+                          left * (px[p - 1] - px[p] + ox) +
+                          down * (px[p + GRID_WIDTH] - px[p]) +
+                          up * (px[p - GRID_WIDTH] - px[p]));
+
+        forceY[i] = hk * (right * (py[p + 1] - py[p]) +
+                          left * (py[p - 1] - py[p]) +
+                          down * (py[p + GRID_WIDTH] - py[p] - oy) +
+                          up * (py[p - GRID_WIDTH] - py[p] + oy));
+    }
 }
 
-static float modelStepObject(Object *object, float friction, float *force)
-{
-    object->theta += 0.05f;
+/*
+ * Advance all objects by one step. Immobile objects do not move and do not
+ * count towards the returned sums.
+ */
+static void modelStepObjects(Model *model, float friction, float k,
+        float *velocitySum, float *forceSum)
+{
+    float forceX[MODEL_NUM_OBJECTS], forceY[MODEL_NUM_OBJECTS];
+    float *restrict px = model->positionX + POS(0);
+    float *restrict py = model->positionY + POS(0);
+    float *restrict vx = model->velocityX;
+    float *restrict vy = model->velocityY;
+    float velocity = 0.0f, force = 0.0f;
+    int i;
 
-    if (object->immobile)
-    {
-        object->velocity.x = 0.0f;
-        object->velocity.y = 0.0f;
-        object->force.x = 0.0f;
-        object->force.y = 0.0f;
+    modelSpringForces(model, k, forceX, forceY);
 
-        *force = 0.0f;
-        return 0.0f;
-    }
-    else
+    for (i = 0; i < MODEL_NUM_OBJECTS; i++)
     {
-        object->force.x -= friction * object->velocity.x;
-        object->force.y -= friction * object->velocity.y;
-
-        object->velocity.x += object->force.x / WOBBLY_MASS;
-        object->velocity.y += object->force.y / WOBBLY_MASS;
-
-        object->position.x += object->velocity.x;
-        object->position.y += object->velocity.y;
+        const float mobile = !model->immobile[i];
+        const float fx = forceX[i] - friction * vx[i];
+        const float fy = forceY[i] - friction * vy[i];
 
-        *force = fabs(object->force.x) + fabs(object->force.y);
+        vx[i] = (vx[i] + fx / WOBBLY_MASS) * mobile;
+        vy[i] = (vy[i] + fy / WOBBLY_MASS) * mobile;
 
-        object->force.x = 0.0f;
-        object->force.y = 0.0f;
+        px[i] += vx[i];
+        py[i] += vy[i];
 
-        return fabs(object->velocity.x) + fabs(object->velocity.y);
+        force += (fabsf(fx) + fabsf(fy)) * mobile;
+        velocity += fabsf(vx[i]) + fabsf(vy[i]);
     }
+
+    *velocitySum += velocity;
+    *forceSum += force;
 }
 
 static int modelStep(Model *model, float friction, float k, float time)
 {
-    int   i, j, steps, wobbly = 0;
+    int   j, steps, wobbly = 0;
     float velocitySum = 0.0f;
-    float force, forceSum = 0.0f;
+    float forceSum = 0.0f;
 
     model->steps += time / 15.0f;
     steps = floor (model->steps);
@@ -349,16 +310,7 @@ static int modelStep(Model *model, float friction, float k, float time)
         return 1;
 
     for (j = 0; j < steps; j++)
-    {
-        for (i = 0; i < model->numSprings; i++)
-            springExertForces (&model->springs[i], k);
-
-        for (i = 0; i < model->numObjects; i++)
-        {
-            velocitySum += modelStepObject(&model->objects[i], friction, &force);
-            forceSum += force;
-        }
-    }
+        modelStepObjects(model, friction, k, &velocitySum, &forceSum);
 
     modelCalcBounds (model);
 
@@ -370,38 +322,52 @@ static int modelStep(Model *model, float friction, float k, float time)
     return wobbly;
 }
 
-static void bezierPatchEvaluate (Model *model, float u, float v,
-        float *patchX, float *patchY)
+/*
+ * Get the coefficients of the four cubic Bernstein polynomials at the
+ * points i / cells for i = 0 .. cells, four consecutive floats per point.
+ *
+ * The tables do not depend on the model, so they are shared between all
+ * surfaces with the same mesh resolution.
+ *
+ * keep is a table returned earlier which the caller still uses, it is not
+ * evicted from the cache. May be NULL.
+ */
+static const float *bernsteinCoefficients(int cells, const float *keep)
 {
-    float coeffsU[4], coeffsV[4];
-    float x, y;
-    int   i, j;
-
-    coeffsU[0] = (1 - u) * (1 - u) * (1 - u);
-    coeffsU[1] = 3 * u * (1 - u) * (1 - u);
-    coeffsU[2] = 3 * u * u * (1 - u);
-    coeffsU[3] = u * u * u;
+    BernsteinTable *table;
+    float *coeffs;
+    int i;
 
-    coeffsV[0] = (1 - v) * (1 - v) * (1 - v);
-    coeffsV[1] = 3 * v * (1 - v) * (1 - v);
-    coeffsV[2] = 3 * v * v * (1 - v);
-    coeffsV[3] = v * v * v;
+    for (i = 0; i < MAX_BERNSTEIN_TABLES; i++)
+    {
+        if (bernsteinTables[i].coeffs && bernsteinTables[i].cells == cells)
+            return bernsteinTables[i].coeffs;
+    }
 
-    x = y = 0.0f;
+    coeffs = malloc(sizeof(float) * 4 * (cells + 1));
+    if (!coeffs)
+        return NULL;
 
-    for (i = 0; i < 4; i++)
+    for (i = 0; i <= cells; i++)
     {
-        for (j = 0; j < 4; j++)
-        {
-            x += coeffsU[i] * coeffsV[j] *
-                model->objects[j * GRID_WIDTH + i].position.x;
-            y += coeffsU[i] * coeffsV[j] *
-                model->objects[j * GRID_HEIGHT + i].position.y;
-        }
+        float u = (float) i / cells;
+        coeffs[4 * i + 0] = (1 - u) * (1 - u) * (1 - u);
+        coeffs[4 * i + 1] = 3 * u * (1 - u) * (1 - u);
+        coeffs[4 * i + 2] = 3 * u * u * (1 - u);
+        coeffs[4 * i + 3] = u * u * u;
     }
 
-    *patchX = x;
-    *patchY = y;
+    if (keep && bernsteinTables[nextBernsteinTable].coeffs == keep)
+        nextBernsteinTable = (nextBernsteinTable + 1) % MAX_BERNSTEIN_TABLES;
+
+    table = &bernsteinTables[nextBernsteinTable];
+    nextBernsteinTable = (nextBernsteinTable + 1) % MAX_BERNSTEIN_TABLES;
+
+    free(table->coeffs);
+    table->cells  = cells;
+    table->coeffs = coeffs;
+
+    return coeffs;
 }
 
 static int wobblyEnsureModel(struct wobbly_surface *surface)
@@ -419,105 +385,104 @@ static int wobblyEnsureModel(struct wobbly_surface *surface)
     return 1;
 }
 
-static float objectDistance(Object *object, float x, float y)
+static float objectDistance(Model *model, int i, float x, float y)
 {
     float dx, dy;
-    dx = object->position.x - x;
-    dy = object->position.y - y;
+    dx = model->positionX[POS(i)] - x;
+    dy = model->positionY[POS(i)] - y;
 
     return sqrt(dx * dx + dy * dy);
 }
 
-static Object *modelFindNearestObject(Model *model, float x, float y)
+static int modelFindNearestObject(Model *model, float x, float y)
 {
-    Object *object = &model->objects[0];
+    int    object = 0;
     float  distance, minDistance = 0.0;
     int    i;
 
     for (i = 0; i < model->numObjects; i++)
     {
-        distance = objectDistance(&model->objects[i], x, y);
+        distance = objectDistance(model, i, x, y);
         if (i == 0 || distance < minDistance)
         {
             minDistance = distance;
-            object = &model->objects[i];
+            object = i;
         }
     }
 
     return object;
 }
 
-static void modelAdjustCorners(Model *model, int x, int y,
-        int width, int height, int make_immobile)
+/*
+ * Give the neighbours of the given object a push towards it, along the
+ * springs which connect them.
+ */
+static void modelPushNeighbours(Model *model, int object)
 {
-    Object *o;
-    o = &model->objects[0];
-    o->position.x = x;
-    o->position.y = y;
-    o->immobile = make_immobile;
+    const float dx = model->springOffsetX * 0.05f;
+    const float dy = model->springOffsetY * 0.05f;
+    const int gridX = object % GRID_WIDTH;
 
-    o = &model->objects[GRID_WIDTH - 1];
-    o->position.x = x + width;
-    o->position.y = y;
-    o->immobile = make_immobile;
+    if (gridX < GRID_WIDTH - 1)
+        model->velocityX[object + 1] -= dx;
+    if (gridX > 0)
+        model->velocityX[object - 1] += dx;
+    if (object < MODEL_NUM_OBJECTS - GRID_WIDTH)
+        model->velocityY[object + GRID_WIDTH] -= dy;
+    if (object >= GRID_WIDTH)
+        model->velocityY[object - GRID_WIDTH] += dy;
+}
 
-    o = &model->objects[GRID_WIDTH * (GRID_HEIGHT - 1)];
-    o->position.x = x;
-    o->position.y = y + height;
-    o->immobile = make_immobile;
+static void modelMoveObject(Model *model, int i, float x, float y,
+        int make_immobile)
+{
+    model->positionX[POS(i)] = x;
+    model->positionY[POS(i)] = y;
+    model->immobile[i] = make_immobile;
+}
 
-    o = &model->objects[model->numObjects - 1];
-    o->position.x = x + width;
-    o->position.y = y + height;
-    o->immobile = make_immobile;
+static void modelAdjustCorners(Model *model, int x, int y,
+        int width, int height, int make_immobile)
+{
+    modelMoveObject(model, 0, x, y, make_immobile);
+    modelMoveObject(model, GRID_WIDTH - 1, x + width, y, make_immobile);
+    modelMoveObject(model, GRID_WIDTH * (GRID_HEIGHT - 1),
+        x, y + height, make_immobile);
+    modelMoveObject(model, model->numObjects - 1,
+        x + width, y + height, make_immobile);
 
-    if (!model->anchorObject)
-        model->anchorObject = &model->objects[0];
+    if (model->anchorObject == NO_OBJECT)
+        model->anchorObject = 0;
 }
 
-static int modelRemoveEdgeAnchors(Model *model)
+static int modelReleaseObject(Model *model, int i)
 {
     int result = 0;
-    Object *o;
-
-    o = &model->objects[0];
-    if (o != model->anchorObject)
+    if (i != model->anchorObject)
     {
-        result |= o->immobile;
-        o->immobile = 0;
+        result = model->immobile[i];
+        model->immobile[i] = 0;
     }
 
-    o = &model->objects[GRID_WIDTH - 1];
-    if (o != model->anchorObject)
-    {
-        result |= o->immobile;
-        o->immobile = 0;
-    }
+    return result;
+}
 
-    o = &model->objects[GRID_WIDTH * (GRID_HEIGHT - 1)];
-    if (o != model->anchorObject)
-    {
-        result |= o->immobile;
-        o->immobile = 0;
-    }
+static int modelRemoveEdgeAnchors(Model *model)
+{
+    int result = 0;
 
-    o = &model->objects[model->numObjects - 1];
-    if (o != model->anchorObject)
-    {
-        result |= o->immobile;
-        o->immobile = 0;
-    }
+    result |= modelReleaseObject(model, 0);
+    result |= modelReleaseObject(model, GRID_WIDTH - 1);
+    result |= modelReleaseObject(model, GRID_WIDTH * (GRID_HEIGHT - 1));
+    result |= modelReleaseObject(model, model->numObjects - 1);
 
     return result;
 }
 
-void wobbly_prepare_paint(struct wobbly_surface *surface, int msSinceLastPaint)
+static void wobblyStep(struct wobbly_surface *surface, int msSinceLastPaint,
+        float friction, float springK)
 {
     WobblyWindow *ww = surface->ww;
-    float  friction, springK;
-
-    friction = wobbly_settings_get_friction();
-    springK  = wobbly_settings_get_spring_k();
 
     if (ww->wobbly)
     {
@@ -538,6 +503,24 @@ void wobbly_prepare_paint(struct wobbly_surface *surface, int msSinceLastPaint)
     }
 }
 
+void wobbly_prepare_paint(struct wobbly_surface *surface, int msSinceLastPaint)
+{
+    wobbly_prepare_paint_batch(&surface, &msSinceLastPaint, 1);
+}
+
+void wobbly_prepare_paint_batch(struct wobbly_surface **surfaces,
+    const int *msSinceLastPaint, int count)
+{
+    float  friction, springK;
+    int    i;
+
+    friction = wobbly_settings_get_friction();
+    springK  = wobbly_settings_get_spring_k();
+
+    for (i = 0; i < count; i++)
+        wobblyStep(surfaces[i], msSinceLastPaint[i], friction, springK);
+}
+
 void wobbly_done_paint(struct wobbly_surface *surface)
 {
     WobblyWindow *ww = (WobblyWindow*)surface->ww;
@@ -551,45 +534,61 @@ void wobbly_done_paint(struct wobbly_surface *surface)
 void wobbly_add_geometry(struct wobbly_surface *surface)
 {
     WobblyWindow *ww = surface->ww;
+    Model        *model = ww->model;
 
-    float    width, height;
-    float    deformedX, deformedY;
-    int      x, y, iw, ih;
-    float    cell_w, cell_h;
-    GLfloat  *v, *uv;
+    const float *coeffsU, *coeffsV;
+    float    rowX[GRID_WIDTH], rowY[GRID_WIDTH];
+    int      x, y, i, j, iw, ih;
+    GLfloat  *v;
 
     if (ww->wobbly)
     {
-        width  = surface->width;
-        height = surface->height;
-
-        cell_w = width / surface->x_cells;
-        cell_h = height / surface->y_cells;
+        coeffsU = bernsteinCoefficients(surface->x_cells, NULL);
+        coeffsV = bernsteinCoefficients(surface->y_cells, coeffsU);
+        if (!coeffsU || !coeffsV)
+            return;
 
         iw = surface->x_cells + 1;
         ih = surface->y_cells + 1;
 
-        v = realloc(surface->v, sizeof(GLfloat) * 2 * iw * ih);
-        uv = realloc(surface->uv, sizeof(GLfloat) * 2 * iw * ih);
+        if (surface->vertex_count != iw * ih)
+        {
+            v = realloc(surface->v, sizeof(GLfloat) * 2 * iw * ih);
+            if (!v)
+                return;
 
-        surface->v = v;
-        surface->uv = uv;
+            surface->v = v;
+            surface->vertex_count = iw * ih;
+        }
 
+        v = surface->v;
         for (y = 0; y < ih; y++)
         {
-            for (x = 0; x < iw; x++)
+            /* Collapse the patch along v for this row, then evaluate the
+             * resulting cubic curve along u for each vertex of the row. */
+            for (i = 0; i < GRID_WIDTH; i++)
             {
-                bezierPatchEvaluate(ww->model,
-                        (x * cell_w) / width, (y * cell_h) / height,
-                        &deformedX, &deformedY);
-
-                *v++ = deformedX;
-                *v++ = deformedY;
+                rowX[i] = rowY[i] = 0.0f;
+                for (j = 0; j < GRID_HEIGHT; j++)
+                {
+                    rowX[i] += coeffsV[4 * y + j] *
+                        model->positionX[POS(j * GRID_WIDTH + i)];
+                    rowY[i] += coeffsV[4 * y + j] *
+                        model->positionY[POS(j * GRID_WIDTH + i)];
+                }
+            }
 
-                *uv++ = (x * cell_w) / width;
-                *uv++ = 1.0 - ((y * cell_h) / height);
+            for (x = 0; x < iw; x++)
+            {
+                const float *cu = &coeffsU[4 * x];
+                *v++ = cu[0] * rowX[0] + cu[1] * rowX[1] +
+                    cu[2] * rowX[2] + cu[3] * rowX[3];
+                *v++ = cu[0] * rowY[0] + cu[1] * rowY[1] +
+                    cu[2] * rowY[2] + cu[3] * rowY[3];
             }
         }
+
+        surface->geometry_serial++;
     }
 }
 
@@ -615,8 +614,8 @@ void wobbly_move_notify(struct wobbly_surface *surface, int x, int y)
     WobblyWindow *ww = surface->ww;
     if (ww->grabbed)
     {
-        ww->model->anchorObject->position.x = x + ww->grab_dx;
-        ww->model->anchorObject->position.y = y + ww->grab_dy;
+        ww->model->positionX[POS(ww->model->anchorObject)] = x + ww->grab_dx;
+        ww->model->positionY[POS(ww->model->anchorObject)] = y + ww->grab_dy;
 
         ww->wobbly |= WobblyInitial;
         surface->synced = 0;
@@ -628,28 +627,12 @@ void wobbly_slight_wobble(struct wobbly_surface *surface)
     WobblyWindow *ww = surface->ww;
     if (wobblyEnsureModel(surface))
     {
-        Object *centerObj;
-        Spring *s;
-        int	   i;
+        int centerObj;
 
         centerObj = modelFindNearestObject(ww->model,
             surface->x + surface->width / 2, surface->y + surface->height / 2);
 
-        for (i = 0; i < ww->model->numSprings; i++)
-        {
-            s = &ww->model->springs[i];
-
-            if (s->a == centerObj)
-            {
-                s->b->velocity.x -= s->offset.x * 0.05f;
-                s->b->velocity.y -= s->offset.y * 0.05f;
-            }
-            else if (s->b == centerObj)
-            {
-                s->a->velocity.x += s->offset.x * 0.05f;
-                s->a->velocity.y += s->offset.y * 0.05f;
-            }
-        }
+        modelPushNeighbours(ww->model, centerObj);
 
         ww->wobbly |= WobblyInitial;
     }
@@ -671,33 +654,18 @@ void wobbly_grab_notify(struct wobbly_surface *surface, int x, int y)
 
     if (wobblyEnsureModel(surface))
     {
-        Spring *s;
-        int	   i;
+        Model *model = ww->model;
 
-        if (ww->model->anchorObject)
-            ww->model->anchorObject->immobile = 0;
+        if (model->anchorObject != NO_OBJECT)
+            model->immobile[model->anchorObject] = 0;
 
-        ww->model->anchorObject = modelFindNearestObject(ww->model, x, y);
-        ww->model->anchorObject->immobile = 1;
-        ww->grab_dx = ww->model->anchorObject->position.x - x;
-        ww->grab_dy = ww->model->anchorObject->position.y - y;
+        model->anchorObject = modelFindNearestObject(model, x, y);
+        model->immobile[model->anchorObject] = 1;
+        ww->grab_dx = model->positionX[POS(model->anchorObject)] - x;
+        ww->grab_dy = model->positionY[POS(model->anchorObject)] - y;
 
         ww->grabbed = 1;
-        for (i = 0; i < ww->model->numSprings; i++)
-        {
-            s = &ww->model->springs[i];
-
-            if (s->a == ww->model->anchorObject)
-            {
-                s->b->velocity.x -= s->offset.x * 0.05f;
-                s->b->velocity.y -= s->offset.y * 0.05f;
-            }
-            else if (s->b == ww->model->anchorObject)
-            {
-                s->a->velocity.x += s->offset.x * 0.05f;
-                s->a->velocity.y += s->offset.y * 0.05f;
-            }
-        }
+        modelPushNeighbours(model, model->anchorObject);
 
         ww->wobbly |= WobblyInitial;
     }
@@ -710,10 +678,10 @@ void wobbly_ungrab_notify(struct wobbly_surface *surface)
     {
         if (ww->model)
         {
-            if (ww->model->anchorObject)
-                ww->model->anchorObject->immobile = 0;
+            if (ww->model->anchorObject != NO_OBJECT)
+                ww->model->immobile[ww->model->anchorObject] = 0;
 
-            ww->model->anchorObject = NULL;
+            ww->model->anchorObject = NO_OBJECT;
 
             ww->wobbly |= WobblyInitial;
         }
@@ -751,7 +719,6 @@ void wobbly_fini(struct wobbly_surface *surface)
 
     if (ww->model)
     {
-        free(ww->model->objects);
         free(ww->model);
         free(surface->v);
     }
@@ -766,10 +733,10 @@ void wobbly_force_geometry(struct wobbly_surface *surface,
 
     if (wobblyEnsureModel(surface))
     {
-		if (!ww->grabbed && ww->model->anchorObject)
+		if (!ww->grabbed && ww->model->anchorObject != NO_OBJECT)
 		{
-		    ww->model->anchorObject->immobile = 0;
-		    ww->model->anchorObject = NULL;
+		    ww->model->immobile[ww->model->anchorObject] = 0;
+		    ww->model->anchorObject = NO_OBJECT;
 		}
 
         surface->x = x;
@@ -793,7 +760,8 @@ void wobbly_unenforce_geometry(struct wobbly_surface *surface)
     {
         if (modelRemoveEdgeAnchors(ww->model))
         {
-            if (!ww->model->anchorObject || !ww->model->anchorObject->immobile)
+            if (ww->model->anchorObject == NO_OBJECT ||
+                !ww->model->immobile[ww->model->anchorObject])
             {
                 modelSetMiddleAnchor(ww->model, surface->x, surface->y,
                     surface->width, surface->height);
@@ -812,8 +780,8 @@ void wobbly_translate(struct wobbly_surface *surface, int dx, int dy)
     {
         for (int i = 0; i < ww->model->numObjects; i++)
         {
-            ww->model->objects[i].position.x += dx;
-            ww->model->objects[i].position.y += dy;
+            ww->model->positionX[POS(i)] += dx;
+            ww->model->positionY[POS(i)] += dy;
         }
 
         ww->model->topLeft.x += dx;
@@ -835,8 +803,8 @@ void wobbly_scale(struct wobbly_surface *surface, double dx, double dy)
     {
         for (int i = 0; i < ww->model->numObjects; i++)
         {
-            scale(surface->x, &ww->model->objects[i].position.x, dx);
-            scale(surface->y, &ww->model->objects[i].position.y, dy);
+            scale(surface->x, &ww->model->positionX[POS(i)], dx);
+            scale(surface->y, &ww->model->positionY[POS(i)], dy);
         }
 
         scale(surface->x, &ww->model->topLeft.x, dx);
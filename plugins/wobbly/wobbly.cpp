@@ -1,6 +1,8 @@
 #include "wayfire/debug.hpp"
 #include "wayfire/opengl.hpp"
 #include "wayfire/region.hpp"
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <wayfire/plugin.hpp>
 #include <wayfire/signal-definitions.hpp>
@@ -8,6 +10,7 @@
 #include <wayfire/view-transform.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/render-manager.hpp>
+#include <wayfire/animation-scheduler.hpp>
 #include <wayfire/plugins/common/util.hpp>
 
 extern "C"
@@ -53,6 +56,19 @@ void main()
 OpenGL::program_t program;
 int times_loaded = 0;
 
+/**
+ * The GPU buffers which depend only on the mesh resolution: the triangle
+ * indices and the texture coordinates. They are shared by all wobbly views.
+ */
+struct mesh_buffers_t
+{
+    GLuint indices = 0;
+    GLuint uv = 0;
+    int index_count = 0;
+};
+
+std::map<std::pair<int, int>, mesh_buffers_t> meshes;
+
 void load_program()
 {
     if (times_loaded++ > 0)
@@ -71,81 +87,175 @@ void destroy_program()
     {
         OpenGL::render_begin();
         program.free_resources();
+        for (auto& [_, mesh] : meshes)
+        {
+            GL_CALL(glDeleteBuffers(1, &mesh.indices));
+            GL_CALL(glDeleteBuffers(1, &mesh.uv));
+        }
+
+        meshes.clear();
         OpenGL::render_end();
     }
 }
 
 /**
- * Enumerate the needed triangles for rendering the model
+ * Get the index and texture coordinate buffers for the given resolution.
+ * The vertices are laid out row by row, as in wobbly_surface::v.
+ *
+ * Requires bound opengl context.
  */
-void prepare_geometry(wobbly_surface *model, wf::geometry_t src_box,
-    std::vector<float>& vert, std::vector<float>& uv)
+const mesh_buffers_t& get_mesh_buffers(int x_cells, int y_cells)
 {
-    float x = src_box.x, y = src_box.y, w = src_box.width, h = src_box.height;
-    std::vector<int> idx;
-
-    int per_row = model->x_cells + 1;
+    auto& mesh = meshes[{x_cells, y_cells}];
+    if (mesh.indices)
+    {
+        return mesh;
+    }
 
-    for (int j = 0; j < model->y_cells; j++)
+    int per_row = x_cells + 1;
+    std::vector<GLushort> idx;
+    for (int j = 0; j < y_cells; j++)
     {
-        for (int i = 0; i < model->x_cells; i++)
+        for (int i = 0; i < x_cells; i++)
         {
-            idx.push_back(i * per_row + j);
-            idx.push_back((i + 1) * per_row + j + 1);
-            idx.push_back(i * per_row + j + 1);
+            idx.push_back(j * per_row + i);
+            idx.push_back((j + 1) * per_row + i + 1);
+            idx.push_back((j + 1) * per_row + i);
 
-            idx.push_back(i * per_row + j);
-            idx.push_back((i + 1) * per_row + j);
-            idx.push_back((i + 1) * per_row + j + 1);
+            idx.push_back(j * per_row + i);
+            idx.push_back(j * per_row + i + 1);
+            idx.push_back((j + 1) * per_row + i + 1);
         }
     }
 
-    if (!model->v || !model->uv)
+    std::vector<float> uv;
+    for (int j = 0; j <= y_cells; j++)
     {
-        for (auto id : idx)
+        for (int i = 0; i <= x_cells; i++)
         {
-            float tile_w = w / model->x_cells;
-            float tile_h = h / model->y_cells;
+            uv.push_back(1.0f * i / x_cells);
+            uv.push_back(1.0f - 1.0f * j / y_cells);
+        }
+    }
 
-            int i = id / per_row;
-            int j = id % per_row;
+    GL_CALL(glGenBuffers(1, &mesh.indices));
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indices));
+    GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(GLushort),
+        idx.data(), GL_STATIC_DRAW));
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
 
-            vert.push_back(i * tile_w + x);
-            vert.push_back(j * tile_h + y);
+    GL_CALL(glGenBuffers(1, &mesh.uv));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mesh.uv));
+    GL_CALL(glBufferData(GL_ARRAY_BUFFER, uv.size() * sizeof(float),
+        uv.data(), GL_STATIC_DRAW));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
-            uv.push_back(1.0f * i / model->x_cells);
-            uv.push_back(1.0f - 1.0f * j / model->y_cells);
-        }
-    } else
+    mesh.index_count = idx.size();
+    return mesh;
+}
+
+/**
+ * The vertex positions of a single wobbly model, kept in a buffer on the GPU.
+ * They are uploaded again only when the model geometry has changed.
+ *
+ * Requires bound opengl context for all operations.
+ */
+class mesh_positions_t
+{
+  public:
+    GLuint get_buffer() const
     {
-        for (auto i : idx)
+        return vbo;
+    }
+
+    void update(wobbly_surface *model, wf::geometry_t src_box)
+    {
+        if (!vbo)
+        {
+            GL_CALL(glGenBuffers(1, &vbo));
+        }
+
+        std::vector<float> flat;
+        const float *data = model->v;
+        if (!model->v)
         {
-            vert.push_back(model->v[2 * i]);
-            vert.push_back(model->v[2 * i + 1]);
+            /* The model has not been deformed yet */
+            float tile_w = 1.0f * src_box.width / model->x_cells;
+            float tile_h = 1.0f * src_box.height / model->y_cells;
+            for (int j = 0; j <= model->y_cells; j++)
+            {
+                for (int i = 0; i <= model->x_cells; i++)
+                {
+                    flat.push_back(i * tile_w + src_box.x);
+                    flat.push_back(j * tile_h + src_box.y);
+                }
+            }
+
+            data = flat.data();
+        } else if (uploaded && (uploaded_serial == model->geometry_serial))
+        {
+            return;
+        }
 
-            uv.push_back(model->uv[2 * i]);
-            uv.push_back(model->uv[2 * i + 1]);
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo));
+        GL_CALL(glBufferData(GL_ARRAY_BUFFER,
+            sizeof(float) * 2 * (model->x_cells + 1) * (model->y_cells + 1),
+            data, GL_STREAM_DRAW));
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+        uploaded = (model->v != nullptr);
+        uploaded_serial = model->geometry_serial;
+    }
+
+    void free_resources()
+    {
+        if (vbo)
+        {
+            GL_CALL(glDeleteBuffers(1, &vbo));
+            vbo = 0;
         }
     }
-}
 
-/* Requires bound opengl context */
-void render_triangles(wf::texture_t tex, glm::mat4 mat, float *pos, float *uv,
-    int cnt)
+  private:
+    GLuint vbo = 0;
+    bool uploaded = false;
+    unsigned int uploaded_serial = 0;
+};
+
+/**
+ * Draw the mesh once for each damaged rectangle. The vertex data is already
+ * on the GPU, so every additional rectangle costs only a scissor change and
+ * a draw call.
+ *
+ * Requires bound opengl context.
+ */
+void render_mesh(wf::texture_t tex, const wf::render_target_t& fb,
+    const mesh_buffers_t& mesh, const mesh_positions_t& positions,
+    const wf::region_t& damage)
 {
     program.use(tex.type);
     program.set_active_texture(tex);
 
-    program.attrib_pointer("position", 2, 0, pos);
-    program.attrib_pointer("uvPosition", 2, 0, uv);
-    program.uniformMatrix4f("MVP", mat);
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, positions.get_buffer()));
+    program.attrib_pointer("position", 2, 0, nullptr);
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mesh.uv));
+    program.attrib_pointer("uvPosition", 2, 0, nullptr);
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    program.uniformMatrix4f("MVP", fb.get_orthographic_projection());
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indices));
 
-    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 3 * cnt));
-    GL_CALL(glDisable(GL_BLEND));
+    for (auto& box : damage)
+    {
+        fb.logic_scissor(wlr_box_from_pixman_box(box));
+        GL_CALL(glDrawElements(GL_TRIANGLES, mesh.index_count,
+            GL_UNSIGNED_SHORT, nullptr));
+    }
 
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    GL_CALL(glDisable(GL_BLEND));
     program.deactivate();
 }
 }
@@ -555,6 +665,56 @@ class wobbly_state_free_t : public iwobbly_state_t
 };
 }
 
+class wobbly_transformer_node_t;
+
+/**
+ * Steps the models of all wobbly views on an output together, as a single
+ * animation of the output's scheduler, so that the model state of all of them
+ * is processed in one batch.
+ */
+class wobbly_output_batch_t : public wf::custom_data_t
+{
+  public:
+    static nonstd::observer_ptr<wobbly_output_batch_t> get(wf::output_t *output)
+    {
+        auto batch = output->get_data_safe<wobbly_output_batch_t>();
+        batch->output = output;
+        return batch;
+    }
+
+    void add(wobbly_transformer_node_t *node)
+    {
+        if (nodes.empty())
+        {
+            wf::animation_scheduler_t::get(output).add(this, "wobbly",
+                [=] () { update_models(); return true; });
+        }
+
+        nodes.push_back(node);
+    }
+
+    void remove(wobbly_transformer_node_t *node)
+    {
+        auto it = std::find(nodes.begin(), nodes.end(), node);
+        if (it == nodes.end())
+        {
+            return;
+        }
+
+        nodes.erase(it);
+        if (nodes.empty())
+        {
+            wf::animation_scheduler_t::get(output).remove(this);
+        }
+    }
+
+  private:
+    wf::output_t *output = nullptr;
+    std::vector<wobbly_transformer_node_t*> nodes;
+
+    void update_models();
+};
+
 class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
 {
   public:
@@ -564,8 +724,7 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
         init_model();
         last_frame = wf::get_current_time();
 
-        pre_hook = [=] () { update_model(); };
-        view->get_output()->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        wobbly_output_batch_t::get(view->get_output())->add(this);
         view->get_output()->connect_signal("workspace-changed",
             &on_workspace_changed);
 
@@ -585,9 +744,13 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
         state = nullptr;
         wobbly_fini(model.get());
 
+        OpenGL::render_begin();
+        positions.free_resources();
+        OpenGL::render_end();
+
         if (view->get_output())
         {
-            view->get_output()->render->rem_effect(&pre_hook);
+            wobbly_output_batch_t::get(view->get_output())->remove(this);
         }
     }
 
@@ -613,6 +776,7 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
         wf::scene::damage_callback push_damage, wf::output_t *shown_on) override;
 
     std::unique_ptr<wobbly_surface> model;
+    wobbly_graphics::mesh_positions_t positions;
 
     void destroy_self()
     {
@@ -621,7 +785,6 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
 
   private:
     wayfire_view view;
-    wf::effect_hook_t pre_hook;
 
     wf::signal_connection_t view_removed = [=] (wf::signal_data_t*)
     {
@@ -652,7 +815,7 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
         if (!view->get_output())
         {
             // Destructor won't be able to disconnect bc view output is invalid
-            sig->output->render->rem_effect(&pre_hook);
+            wobbly_output_batch_t::get(sig->output)->remove(this);
 
             return destroy_self();
         }
@@ -666,9 +829,8 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
         state->translate_model(old_geometry.x - new_geometry.x,
             old_geometry.y - new_geometry.y);
 
-        sig->output->render->rem_effect(&pre_hook);
-        view->get_output()->render->add_effect(&pre_hook,
-            wf::OUTPUT_EFFECT_PRE);
+        wobbly_output_batch_t::get(sig->output)->remove(this);
+        wobbly_output_batch_t::get(view->get_output())->add(this);
 
         on_workspace_changed.disconnect();
         view->get_output()->connect_signal("workspace-changed",
@@ -692,15 +854,20 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
         model->grabbed = 0;
         model->synced  = 1;
 
-        model->x_cells = wobbly_settings::resolution;
-        model->y_cells = wobbly_settings::resolution;
+        /* Vertices are indexed with 16 bit integers */
+        model->x_cells = wf::clamp((int)wobbly_settings::resolution, 1, 254);
+        model->y_cells = model->x_cells;
 
-        model->v  = NULL;
-        model->uv = NULL;
+        model->v = NULL;
         wobbly_init(model.get());
     }
 
-    void update_model()
+  public:
+    /**
+     * Prepare the model for the next step.
+     * @return The time since the last step, in milliseconds.
+     */
+    int begin_frame()
     {
         view->damage();
 
@@ -710,22 +877,27 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
         state->handle_frame();
         view->connect_signal("geometry-changed", &this->view_geometry_changed);
 
-        /* Update all the wobbly model */
         auto now = wf::get_current_time();
-        wobbly_prepare_paint(model.get(), now - last_frame);
-
-        /* Update wobbly geometry */
+        int elapsed = now - last_frame;
         last_frame = now;
+        return elapsed;
+    }
+
+    /**
+     * Update the mesh after the model has been stepped.
+     * @return Whether the wobbly animation is done.
+     */
+    bool end_frame()
+    {
         wobbly_add_geometry(model.get());
         wobbly_done_paint(model.get());
         view->damage();
 
-        if (state->is_wobbly_done())
-        {
-            destroy_self();
-        }
+        return state->is_wobbly_done();
     }
 
+  private:
+
     /**
      * Update the current wobbly state based on:
      * 1. View state (tiled & fullscreen)
@@ -872,6 +1044,36 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
     }
 };
 
+void wobbly_output_batch_t::update_models()
+{
+    /* Nodes remove themselves from the list when they are destroyed */
+    auto current = nodes;
+
+    std::vector<wobbly_surface*> models;
+    std::vector<int> elapsed;
+    for (auto& node : current)
+    {
+        elapsed.push_back(node->begin_frame());
+        models.push_back(node->model.get());
+    }
+
+    wobbly_prepare_paint_batch(models.data(), elapsed.data(), models.size());
+
+    std::vector<wobbly_transformer_node_t*> done;
+    for (auto& node : current)
+    {
+        if (node->end_frame())
+        {
+            done.push_back(node);
+        }
+    }
+
+    for (auto& node : done)
+    {
+        node->destroy_self();
+    }
+}
+
 class wobbly_render_instance_t :
     public wf::scene::transformer_render_instance_t<wobbly_transformer_node_t>
 {
@@ -886,21 +1088,15 @@ class wobbly_render_instance_t :
     void render(const wf::render_target_t& target_fb,
         const wf::region_t& damage) override
     {
-        std::vector<float> vert, uv;
         auto subbox = self->get_children_bounding_box();
+        auto tex    = get_texture(target_fb.scale);
+        auto model  = self->model.get();
 
-        wobbly_graphics::prepare_geometry(self->model.get(), subbox, vert, uv);
-        auto tex = get_texture(target_fb.scale);
         OpenGL::render_begin(target_fb);
-        for (auto& box : damage)
-        {
-            target_fb.logic_scissor(wlr_box_from_pixman_box(box));
-            wobbly_graphics::render_triangles(tex,
-                target_fb.get_orthographic_projection(),
-                vert.data(), uv.data(),
-                self->model->x_cells * self->model->y_cells * 2);
-        }
-
+        self->positions.update(model, subbox);
+        wobbly_graphics::render_mesh(tex, target_fb,
+            wobbly_graphics::get_mesh_buffers(model->x_cells, model->y_cells),
+            self->positions, damage);
         OpenGL::render_end();
     }
 };
@@ -26,7 +26,10 @@ struct wobbly_surface
    int grabbed, synced;
    int vertex_count;
 
-   GLfloat *v, *uv;
+   /* (x_cells + 1) * (y_cells + 1) deformed vertex positions, row by row */
+   GLfloat *v;
+   /* Incremented whenever v changes */
+   unsigned int geometry_serial;
 };
 
 struct wobbly_rect
@@ -48,6 +51,9 @@ void wobbly_scale(struct wobbly_surface *surface, double dx, double dy);
 void wobbly_resize(struct wobbly_surface *surface, int width, int height);
 void wobbly_move_notify(struct wobbly_surface *surface, int x, int y);
 void wobbly_prepare_paint(struct wobbly_surface *surface, int msSinceLastPaint);
+/* Step several models at once, msSinceLastPaint has one entry per surface */
+void wobbly_prepare_paint_batch(struct wobbly_surface **surfaces,
+    const int *msSinceLastPaint, int count);
 void wobbly_done_paint(struct wobbly_surface *surface);
 void wobbly_add_geometry(struct wobbly_surface *surface);
 struct wobbly_rect wobbly_boundingbox(struct wobbly_surface *surface);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <wayfire/object.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wf
+{
+class output_t;
+
+/** Information about an animation running on an output, for debugging. */
+struct animation_info_t
+{
+    /** The name given when the animation was added */
+    std::string name;
+    /** The number of frames the animation has been stepped */
+    uint32_t frames;
+    /** Time since the animation was added, in ms */
+    double running_ms;
+    /** The longest time between two consecutive steps, in ms */
+    double max_frame_gap_ms;
+    /** The longest time a single step took, in us */
+    double max_step_us;
+};
+
+/**
+ * Steps all animations running on an output once per frame, from a single
+ * pre-render effect hook.
+ *
+ * The hook is installed only while at least one animation is running, so an
+ * output without animations does no per-frame work. The scheduler requests a
+ * frame when the first animation is added, after that the steps are expected
+ * to damage whatever they change, which schedules the next frame.
+ */
+class animation_scheduler_t
+{
+  public:
+    /**
+     * Advance the animation for the upcoming frame.
+     *
+     * @return false if the animation has finished. It is then removed from the
+     *   scheduler.
+     */
+    using step_t = std::function<bool()>;
+
+    /** @return The animation scheduler of the given output. */
+    static animation_scheduler_t& get(wf::output_t *output);
+
+    animation_scheduler_t(wf::output_t *output);
+    ~animation_scheduler_t();
+
+    animation_scheduler_t(const animation_scheduler_t&) = delete;
+    animation_scheduler_t(animation_scheduler_t&&) = delete;
+    animation_scheduler_t& operator =(const animation_scheduler_t&) = delete;
+    animation_scheduler_t& operator =(animation_scheduler_t&&) = delete;
+
+    /**
+     * Start stepping an animation, beginning with the next frame.
+     *
+     * @param owner An address identifying the animation, used to remove it.
+     *   An animation with the same owner is replaced.
+     * @param name A human readable name, shown in the debugging information.
+     * @param step The function advancing the animation.
+     *
+     * It is safe to add and remove animations from inside a step.
+     */
+    void add(const void *owner, std::string name, step_t step);
+
+    /** Stop stepping the animation of the given owner, if there is one. */
+    void remove(const void *owner);
+
+    /** @return Whether any animation is running on the output. */
+    bool is_running() const;
+
+    /** @return The animations running on the output, in the order they were added. */
+    std::vector<animation_info_t> list() const;
+
+  private:
+    class impl;
+    std::unique_ptr<impl> priv;
+};
+}
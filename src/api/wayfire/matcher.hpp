@@ -2,6 +2,7 @@
 
 #include <wayfire/config/option.hpp>
 #include <wayfire/view.hpp>
+#include <vector>
 
 namespace wf
 {
@@ -45,9 +46,38 @@ class view_matcher_t
 
     /**
      * @return True if the view matches the condition specified, false otherwise.
+     *
+     * The result for mapped views is remembered until a property used by the
+     * condition changes (title, app-id, fullscreen, minimized, tiled state,
+     * role or layer), so calling this repeatedly for the same view is cheap.
      */
     bool matches(wayfire_view view);
 
+    /**
+     * @return All views from the given list which match the condition, in the
+     *   same order.
+     */
+    std::vector<wayfire_view> get_matching_views(const std::vector<wayfire_view>& views);
+
+    /**
+     * @return All views in core which match the condition.
+     */
+    std::vector<wayfire_view> get_matching_views();
+
+    /** Counters describing how often the condition had to be evaluated. */
+    struct stats_t
+    {
+        /** Number of calls to matches(), including those from get_matching_views() */
+        uint64_t queries = 0;
+        /** Number of times the condition was actually evaluated */
+        uint64_t evaluations = 0;
+        /** Number of remembered results dropped because the view changed */
+        uint64_t invalidations = 0;
+    };
+
+    /** @return The counters for this matcher. */
+    const stats_t& get_stats() const;
+
     /** Destructor */
     ~view_matcher_t();
 
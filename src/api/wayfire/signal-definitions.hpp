@@ -4,6 +4,9 @@
 #include "wayfire/view.hpp"
 #include "wayfire/output.hpp"
 
+#include <set>
+#include <string>
+
 /**
  * Documentation of signals emitted from core components.
  * Each signal documentation follows the following scheme:
@@ -134,9 +137,40 @@ struct surface_map_state_changed_signal : public wf::signal_data_t
 /**
  * name: reload-config
  * on: core
- * when: When the config file is reloaded
- * argument: unused
+ * when: When the config file is reloaded and at least one option changed.
+ *   Config backends which do not track changes may emit it with nullptr,
+ *   meaning that any option may have changed.
+ */
+struct reload_config_signal : public wf::signal_data_t
+{
+    /** Changed, added and removed options, as section/option. */
+    std::set<std::string> changed_options;
+    /** Whether any key, button or activator binding changed. */
+    bool bindings_changed = false;
+
+    /**
+     * @return Whether an option whose section/option name starts with @prefix
+     *   changed. A section name matches its own options and those of any
+     *   section whose name it is a prefix of, e.g. input and input-device:*.
+     */
+    bool section_changed(const std::string& prefix) const
+    {
+        auto it = changed_options.lower_bound(prefix);
+        return (it != changed_options.end()) &&
+               (it->compare(0, prefix.size(), prefix) == 0);
+    }
+};
+
+/**
+ * @return Whether the reload-config signal with the given data may have
+ *   changed an option whose section/option name starts with @prefix.
  */
+inline bool config_section_changed(wf::signal_data_t *data,
+    const std::string& prefix)
+{
+    auto ev = static_cast<reload_config_signal*>(data);
+    return !ev || ev->section_changed(prefix);
+}
 
 /**
  * name: keyboard-focus-changed
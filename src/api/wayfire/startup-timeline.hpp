@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace wf
+{
+/** A single measured step of the compositor startup. */
+struct startup_event_t
+{
+    /** What was done, for example "opengl" or "plugin-init" */
+    std::string phase;
+    /** The plugin or output the step belongs to, empty if none */
+    std::string detail;
+    /** Start of the step, relative to the start of the process, in ms */
+    double start_ms;
+    /** Duration of the step in ms */
+    double duration_ms;
+};
+
+/**
+ * Measures a startup step from construction until destruction and adds it to
+ * the startup timeline. Steps which finish after startup are not recorded.
+ */
+class startup_phase_t
+{
+  public:
+    startup_phase_t(std::string phase, std::string detail = "");
+    ~startup_phase_t();
+
+    startup_phase_t(const startup_phase_t&) = delete;
+    startup_phase_t& operator =(const startup_phase_t&) = delete;
+
+  private:
+    std::string phase;
+    std::string detail;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @return The steps recorded during startup, in the order in which they
+ *   finished. Nested steps come before the step containing them.
+ */
+const std::vector<startup_event_t>& get_startup_timeline();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct wl_event_source;
+
+namespace wf
+{
+/**
+ * A pool of worker threads which core and plugins can share for CPU-heavy
+ * work, instead of starting their own threads.
+ *
+ * The workers are started on first use. All methods must be called from the
+ * main (Wayland event loop) thread, except for parallel_for(), which may also
+ * be called from within a job running on the pool.
+ */
+class thread_pool_t
+{
+  public:
+    static thread_pool_t& get();
+
+    /**
+     * Split [0, count) into chunks of @grain elements and call @func(start,
+     * end) for each chunk, in parallel. The calling thread works on chunks
+     * too, and the call returns once all chunks are done.
+     *
+     * Chunks are handed out one at a time, so threads which finish early
+     * take over work which would otherwise wait for a busy thread.
+     */
+    void parallel_for(size_t count, size_t grain,
+        const std::function<void(size_t, size_t)>& func);
+
+    /**
+     * Run @job on a worker thread. When it has finished, @done (if set) is
+     * called on the main thread from the Wayland event loop.
+     */
+    void submit(std::function<void()> job, std::function<void()> done = {});
+
+    /** @return The number of worker threads, not counting the caller. */
+    size_t get_num_workers();
+
+    thread_pool_t(const thread_pool_t&) = delete;
+    thread_pool_t& operator =(const thread_pool_t&) = delete;
+
+  private:
+    thread_pool_t() = default;
+    ~thread_pool_t();
+
+    void ensure_started();
+    void worker_loop();
+    void enqueue(std::function<void()> task);
+    static int handle_completions(int fd, uint32_t mask, void *data);
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_cv;
+    bool stopping = false;
+
+    /** Callbacks to run on the main thread, signalled through an eventfd */
+    std::vector<std::function<void()>> completions;
+    std::mutex completions_mutex;
+    int completion_fd = -1;
+    wl_event_source *completion_source = nullptr;
+};
+}
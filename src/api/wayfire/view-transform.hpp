@@ -8,6 +8,7 @@
 #include "wayfire/scene.hpp"
 #include <memory>
 #include <wayfire/opengl.hpp>
+#include <wayfire/util.hpp>
 
 namespace wf
 {
@@ -59,6 +60,18 @@ class transformer_render_instance_t : public render_instance_t
     // children's current content.
     wf::region_t cached_damage;
 
+    // A downscaled copy of the children, see get_texture_or_thumbnail().
+    wf::render_target_t thumbnail;
+    // Damage from the children which is not yet in @thumbnail.
+    wf::region_t thumbnail_damage;
+    // The time of the last refresh of @thumbnail, in milliseconds.
+    int64_t thumbnail_time = 0;
+    wf::wl_timer thumbnail_timer;
+    damage_callback push_to_parent;
+
+    // The minimal time between two refreshes of a thumbnail.
+    static constexpr int THUMBNAIL_REFRESH_MS = 50;
+
     /**
      * Get a texture which contains the contents of the children nodes.
      * If the node has a single child which supports zero-copy texture generation
@@ -122,6 +135,102 @@ class transformer_render_instance_t : public render_instance_t
         return wf::texture_t{inner_content.tex};
     }
 
+    /**
+     * Get a texture which contains the contents of the children nodes, for
+     * rendering with the node's own transform.
+     *
+     * If the node is shown at half of its size or less, the children are
+     * rendered to a downscaled buffer (@thumbnail) instead of using their full
+     * size texture. The thumbnail is refreshed on damage, but at most once every
+     * THUMBNAIL_REFRESH_MS, so that many views with large buffers can be shown
+     * at a small size (for example in an overview) without sampling their
+     * full size buffers on every frame.
+     *
+     * Otherwise, the same as get_texture().
+     */
+    wf::texture_t get_texture_or_thumbnail(float scale)
+    {
+        auto bbox = self->get_children_bounding_box();
+        auto shown_box = self->get_bounding_box();
+        float shown_scale = scale * std::max(
+            (float)shown_box.width / std::max(bbox.width, 1),
+            (float)shown_box.height / std::max(bbox.height, 1));
+
+        if (shown_scale > 0.5)
+        {
+            if (thumbnail.fb != (uint) - 1)
+            {
+                OpenGL::render_begin();
+                thumbnail.release();
+                OpenGL::render_end();
+                thumbnail_timer.disconnect();
+            }
+
+            return get_texture(scale);
+        }
+
+        // Use power of two steps, so that the thumbnail is not reallocated on
+        // every frame while the node is being animated.
+        float thumbnail_scale = 0.5;
+        while ((thumbnail_scale > 1.0 / 16) && (thumbnail_scale / 2 >= shown_scale))
+        {
+            thumbnail_scale /= 2;
+        }
+
+        OpenGL::render_begin();
+        if (inner_content.fb != (uint) - 1)
+        {
+            // Not needed while the thumbnail is in use
+            inner_content.release();
+        }
+
+        bool reallocated = thumbnail.allocate(
+            std::max(1, int(thumbnail_scale * bbox.width)),
+            std::max(1, int(thumbnail_scale * bbox.height)));
+        reallocated |= (thumbnail.scale != thumbnail_scale);
+        thumbnail.geometry = bbox;
+        thumbnail.scale    = thumbnail_scale;
+        OpenGL::render_end();
+
+        if (reallocated)
+        {
+            thumbnail_damage |= bbox;
+            thumbnail_time    = 0;
+        }
+
+        if (thumbnail_damage.empty())
+        {
+            return wf::texture_t{thumbnail.tex};
+        }
+
+        int64_t wait = thumbnail_time + THUMBNAIL_REFRESH_MS - wf::get_current_time();
+        if (wait > 0)
+        {
+            // Show the old thumbnail and repaint once the limit has passed
+            if (!thumbnail_timer.is_connected())
+            {
+                thumbnail_timer.set_timeout(wait, [=] ()
+                {
+                    push_to_parent(self->get_bounding_box());
+                    return false;
+                });
+            }
+
+            return wf::texture_t{thumbnail.tex};
+        }
+
+        render_pass_params_t params;
+        params.instances = &children;
+        params.target    = thumbnail;
+        params.damage    = thumbnail_damage;
+        params.background_color = {0.0f, 0.0f, 0.0f, 0.0f};
+        scene::run_render_pass(params, RPASS_CLEAR_BACKGROUND);
+
+        thumbnail_damage.clear();
+        thumbnail_time = wf::get_current_time();
+        return wf::texture_t{thumbnail.tex};
+    }
+
     void presentation_feedback(wf::output_t *output) override
     {
         for (auto& ch : children)
@@ -142,9 +251,11 @@ class transformer_render_instance_t : public render_instance_t
             "subclass of node_t!");
 
         this->self = self;
+        this->push_to_parent = push_damage;
         auto push_damage_child = [=] (wf::region_t region)
         {
             this->cached_damage |= region;
+            this->thumbnail_damage |= region;
             transform_damage_region(region);
             push_damage(region);
         };
@@ -160,6 +271,7 @@ class transformer_render_instance_t : public render_instance_t
     {
         OpenGL::render_begin();
         inner_content.release();
+        thumbnail.release();
         OpenGL::render_end();
     }
 
@@ -290,6 +402,9 @@ class view_2d_transformer_t : public scene::floating_inner_node_t
     // Note that if the view was not opaque to begin with, setting alpha=1.0
     // does not make it opaque.
     float alpha = 1.0f;
+    // Render from a downscaled copy of the view while it is shown at half of
+    // its size or less. The copy lags behind the view by up to 50ms.
+    bool use_thumbnail = false;
 
     view_2d_transformer_t(wayfire_view view);
     wf::pointf_t to_local(const wf::pointf_t& point) override;
@@ -313,6 +428,9 @@ class view_3d_transformer_t : public scene::floating_inner_node_t
   public:
     glm::mat4 view_proj{1.0}, translation{1.0}, rotation{1.0}, scaling{1.0};
     glm::vec4 color{1, 1, 1, 1};
+    // Render from a downscaled copy of the view while it is shown at half of
+    // its size or less. The copy lags behind the view by up to 50ms.
+    bool use_thumbnail = false;
 
     glm::mat4 calculate_total_transform();
 
@@ -125,6 +125,12 @@ class compositor_core_impl_t : public compositor_core_t
 };
 
 compositor_core_impl_t& get_core_impl();
+
+/**
+ * Stop recording the startup timeline, and print it if requested.
+ * Called by core once startup has finished.
+ */
+void finish_startup_timeline(bool print);
 }
 
 
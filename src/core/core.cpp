@@ -14,6 +14,7 @@
 #include <wayfire/output-layout.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/signal-definitions.hpp>
+#include <wayfire/startup-timeline.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 
 #include "view/surface-impl.hpp"
@@ -163,6 +164,7 @@ struct wlr_idle_inhibitor_t : public wf::idle_inhibitor_t
 
 void wf::compositor_core_impl_t::init()
 {
+    auto protocols_phase = std::make_unique<wf::startup_phase_t>("protocols");
     this->scene_root = std::make_shared<scene::root_node_t>();
 
     wlr_renderer_init_wl_display(renderer, display);
@@ -297,9 +299,18 @@ void wf::compositor_core_impl_t::init()
 
     wf_shell  = wayfire_shell_create(display);
     gtk_shell = wf_gtk_shell_create(display);
+    protocols_phase.reset();
+
+    {
+        wf::startup_phase_t phase{"image-io"};
+        image_io::init();
+    }
+
+    {
+        wf::startup_phase_t phase{"opengl"};
+        OpenGL::init();
+    }
 
-    image_io::init();
-    OpenGL::init();
     this->state = compositor_state_t::START_BACKEND;
 }
 
@@ -323,6 +334,7 @@ void wf::compositor_core_impl_t::post_init()
     seat->cursor->setup_listeners();
 
     this->emit_signal("startup-finished", nullptr);
+    wf::finish_startup_timeline(runtime_config.profile_startup);
 }
 
 void wf::compositor_core_impl_t::shutdown()
@@ -5,18 +5,189 @@
 #include <wayfire/condition/condition.hpp>
 #include <wayfire/view-access-interface.hpp>
 #include <wayfire/parser/condition_parser.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/workspace-manager.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/core.hpp>
+#include <unordered_map>
+#include <set>
+
+namespace
+{
+/**
+ * Properties whose changes are announced by a signal on the view. Results of
+ * conditions which use only these (and role/type, see below) can be
+ * remembered until one of the signals is emitted.
+ */
+const std::set<std::string> signaled_properties = {
+    "app_id", "title", "fullscreen", "minimized", "mapped", "tiled-left",
+    "tiled-right", "tiled-top", "tiled-bottom", "maximized", "floating",
+};
+
+const char *const invalidating_signals[] = {
+    "title-changed", "app-id-changed", "fullscreen", "minimized", "tiled",
+    "mapped",
+};
+
+/**
+ * Records which view properties a condition reads during evaluation.
+ */
+class recording_access_interface_t : public wf::view_access_interface_t
+{
+  public:
+    using view_access_interface_t::view_access_interface_t;
+
+    /** Whether the condition read a property we cannot track. */
+    bool has_untracked = false;
+    /** Whether the condition read the role or type of the view. */
+    bool depends_on_role = false;
+
+    wf::variant_t get(const std::string & identifier, bool & error) override
+    {
+        if ((identifier == "role") || (identifier == "type"))
+        {
+            depends_on_role = true;
+        } else if (!signaled_properties.count(identifier))
+        {
+            has_untracked = true;
+        }
+
+        return view_access_interface_t::get(identifier, error);
+    }
+};
+
+uint32_t get_view_layer(wayfire_view view)
+{
+    if (!view->get_output())
+    {
+        return 0;
+    }
+
+    return view->get_output()->workspace->get_view_layer(view);
+}
+}
 
 class wf::view_matcher_t::impl
 {
   public:
     std::shared_ptr<wf::config::option_t<std::string>> option;
 
+    /**
+     * A remembered result. Role and layer are not announced with signals, so
+     * they are saved and compared on lookup if the condition uses them.
+     */
+    struct memoized_result_t
+    {
+        bool valid = false;
+        bool result;
+        bool depends_on_role;
+        wf::view_role_t role;
+        uint32_t layer;
+    };
+
+    std::unordered_map<wf::view_interface_t*, memoized_result_t> memoized;
+    wf::view_matcher_t::stats_t stats;
+
+    wf::signal_connection_t on_view_changed = [=] (wf::signal_data_t *data)
+    {
+        auto it = memoized.find(get_signaled_view(data).get());
+        if ((it != memoized.end()) && it->second.valid)
+        {
+            it->second.valid = false;
+            ++stats.invalidations;
+        }
+    };
+
+    wf::signal_connection_t on_view_unmapped = [=] (wf::signal_data_t *data)
+    {
+        // Views are destroyed only after being unmapped, so this makes sure we
+        // never keep pointers to dead views.
+        auto view = get_signaled_view(data);
+        forget_view(view);
+    };
+
+    void forget_view(wayfire_view view)
+    {
+        if (memoized.erase(view.get()))
+        {
+            view->disconnect_signal(&on_view_changed);
+            view->disconnect_signal(&on_view_unmapped);
+        }
+    }
+
+    void forget_all_views()
+    {
+        for (auto& entry : memoized)
+        {
+            entry.first->disconnect_signal(&on_view_changed);
+            entry.first->disconnect_signal(&on_view_unmapped);
+        }
+
+        memoized.clear();
+    }
+
+    bool evaluate(wayfire_view view)
+    {
+        ++stats.queries;
+        if (!condition)
+        {
+            return false;
+        }
+
+        auto it = memoized.find(view.get());
+        if ((it != memoized.end()) && it->second.valid)
+        {
+            auto& entry = it->second;
+            if (!entry.depends_on_role ||
+                ((entry.role == view->role) && (entry.layer == get_view_layer(view))))
+            {
+                return entry.result;
+            }
+
+            ++stats.invalidations;
+        }
+
+        ++stats.evaluations;
+        bool error = false;
+        recording_access_interface_t access_interface{view};
+        bool result = condition->evaluate(access_interface, error);
+
+        if (error || access_interface.has_untracked || !view->is_mapped())
+        {
+            return result;
+        }
+
+        if (it == memoized.end())
+        {
+            it = memoized.emplace(view.get(), memoized_result_t{}).first;
+            for (auto signal : invalidating_signals)
+            {
+                view->connect_signal(signal, &on_view_changed);
+            }
+
+            view->connect_signal("unmapped", &on_view_unmapped);
+        }
+
+        auto& entry = it->second;
+        entry.valid  = true;
+        entry.result = result;
+        entry.depends_on_role = access_interface.depends_on_role;
+        if (entry.depends_on_role)
+        {
+            entry.role  = view->role;
+            entry.layer = get_view_layer(view);
+        }
+
+        return result;
+    }
+
     wf::lexer_t lexer;
     wf::condition_parser_t parser;
     std::shared_ptr<wf::condition_t> condition;
 
     bool try_parse(const std::string& value, const std::string& opt_name)
     {
+        forget_all_views();
         lexer.reset(value);
         try {
             condition = parser.parse(lexer);
@@ -75,6 +246,7 @@ class wf::view_matcher_t::impl
     ~impl()
     {
         disconnect_updated_handler();
+        forget_all_views();
     }
 
     impl(const impl &) = delete;
@@ -110,15 +282,32 @@ void wf::view_matcher_t::set_from_option(
 
 bool wf::view_matcher_t::matches(wayfire_view view)
 {
-    if (this->priv->condition)
-    {
-        bool ignored = false;
-        wf::view_access_interface_t access_interface{view};
+    return this->priv->evaluate(view);
+}
 
-        return this->priv->condition->evaluate(access_interface, ignored);
+std::vector<wayfire_view> wf::view_matcher_t::get_matching_views(
+    const std::vector<wayfire_view>& views)
+{
+    std::vector<wayfire_view> result;
+    for (auto& view : views)
+    {
+        if (this->priv->evaluate(view))
+        {
+            result.push_back(view);
+        }
     }
 
-    return false;
+    return result;
+}
+
+std::vector<wayfire_view> wf::view_matcher_t::get_matching_views()
+{
+    return get_matching_views(wf::get_core().get_all_views());
+}
+
+const wf::view_matcher_t::stats_t& wf::view_matcher_t::get_stats() const
+{
+    return this->priv->stats;
 }
 
 wf::view_matcher_t::~view_matcher_t() = default;
@@ -320,7 +320,8 @@ struct output_layout_output_t
                 current_state.mode.refresh = handle->refresh;
                 this->output->set_effective_size(get_effective_size());
                 this->output->render->damage_whole();
-                emit_configuration_changed(wf::OUTPUT_MODE_CHANGE);
+                pending_changed_fields |= wf::OUTPUT_MODE_CHANGE;
+                emit_configuration_changed();
             }
         }
     }
@@ -586,14 +587,28 @@ struct output_layout_output_t
             return true;
         }
 
-        /* XXX: are there more things to check? */
         refresh_custom_modes();
+        if (!is_mode_supported(state.mode))
+        {
+            return false;
+        }
+
+        if (state.source != OUTPUT_IMAGE_SOURCE_SELF)
+        {
+            return true;
+        }
+
+        /* Let the backend check the whole state, e.g. whether there are
+         * enough CRTCs and bandwidth for the mode */
+        stage_state(state);
+        bool ok = wlr_output_test(handle);
+        wlr_output_rollback(handle);
 
-        return is_mode_supported(state.mode);
+        return ok;
     }
 
-    /** Change the output mode */
-    void apply_mode(const wlr_output_mode& mode)
+    /** Set the output mode as pending, without committing it. */
+    void stage_mode(const wlr_output_mode& mode)
     {
         if (handle->current_mode)
         {
@@ -602,9 +617,6 @@ struct output_layout_output_t
                 (handle->current_mode->height == mode.height) &&
                 (handle->current_mode->refresh == mode.refresh))
             {
-                /* Commit the enabling of the output */
-                wlr_output_commit(handle);
-
                 return;
             }
         }
@@ -624,8 +636,33 @@ struct output_layout_output_t
             wlr_output_set_custom_mode(handle, mode.width, mode.height,
                 mode.refresh);
         }
+    }
 
-        wlr_output_commit(handle);
+    /**
+     * Set everything in the given state (except position) as pending, so that
+     * it can be tested or applied with a single commit.
+     */
+    void stage_state(const output_state_t& state)
+    {
+        bool enabled = !(state.source & OUTPUT_IMAGE_SOURCE_NONE);
+        wlr_output_enable(handle, enabled);
+        if (enabled)
+        {
+            stage_mode(state.mode);
+        }
+
+        if (state.source & OUTPUT_IMAGE_SOURCE_SELF)
+        {
+            if (handle->transform != state.transform)
+            {
+                wlr_output_set_transform(handle, state.transform);
+            }
+
+            if (handle->scale != state.scale)
+            {
+                wlr_output_set_scale(handle, state.scale);
+            }
+        }
     }
 
     /* Mirroring implementation */
@@ -785,12 +822,18 @@ struct output_layout_output_t
         return effective_size;
     }
 
+    /** Fields changed by apply_state() which have not been signalled yet */
+    uint32_t pending_changed_fields = 0;
+
     /**
-     * Send the output-configuration-changed signal.
+     * Send the output-configuration-changed signal for all changes since the
+     * last call.
      */
-    void emit_configuration_changed(uint32_t changed_fields)
+    void emit_configuration_changed()
     {
-        if ((handle->data != WF_NOOP_OUTPUT_MAGIC) && changed_fields)
+        uint32_t changed_fields = pending_changed_fields;
+        pending_changed_fields = 0;
+        if ((handle->data != WF_NOOP_OUTPUT_MAGIC) && changed_fields && output)
         {
             wf::output_configuration_changed_signal data{current_state};
             data.output = output.get();
@@ -800,6 +843,10 @@ struct output_layout_output_t
     }
 
     /** Apply the given state to the output, ignoring position.
+     *
+     * The state is committed at once. The output-configuration-changed signal
+     * is not sent until emit_configuration_changed() is called, so that
+     * plugins see the final layout when several outputs change together.
      *
      * This won't have any effect if the output state can't be applied,
      * i.e if test_state(state) == false */
@@ -839,6 +886,7 @@ struct output_layout_output_t
         }
 
         this->current_state = state;
+        this->pending_changed_fields |= changed_fields;
 
         /* Even if output will remain mirrored, we can tear it down and set
          * up again, in case the output to mirror from changed */
@@ -853,27 +901,20 @@ struct output_layout_output_t
             return;
         }
 
-        set_enabled(!(state.source & OUTPUT_IMAGE_SOURCE_NONE));
-        apply_mode(state.mode);
+        bool scale_changed = (handle->scale != state.scale);
+        stage_state(state);
+        wlr_output_commit(handle);
+
         if (state.source & OUTPUT_IMAGE_SOURCE_SELF)
         {
-            if (handle->transform != state.transform)
+            if (scale_changed)
             {
-                wlr_output_set_transform(handle, state.transform);
-            }
-
-            if (handle->scale != state.scale)
-            {
-                wlr_output_set_scale(handle, state.scale);
                 wf::get_core_impl().seat->cursor->load_xcursor_scale(
                     state.scale);
             }
 
-            wlr_output_commit(handle);
-
             ensure_wayfire_output(get_effective_size());
             output->render->damage_whole();
-            emit_configuration_changed(changed_fields);
         } else /* state.source == OUTPUT_IMAGE_SOURCE_MIRROR */
         {
             destroy_wayfire_output();
@@ -900,6 +941,19 @@ class output_layout_t::impl
     wl_idle_call idle_update_configuration;
     wl_timer timer_remove_noop;
 
+    /**
+     * Outputs which were connected while the compositor is running are
+     * configured only after no other output has been connected for this long.
+     * When docks or KVM switches flap, this results in a single
+     * reconfiguration, and outputs which disappear again in the meantime never
+     * get plugins or views.
+     */
+    static constexpr int HOTPLUG_COALESCE_MS = 250;
+
+    /** Connected outputs which are waiting to be configured */
+    std::map<wlr_output*, std::unique_ptr<output_layout_output_t>> pending_outputs;
+    wl_timer timer_configure_pending;
+
     wlr_backend *noop_backend;
     /* Wayfire generally assumes that an enabled output is always available.
      * However, when switching connectors or something it might happen that
@@ -926,6 +980,7 @@ class output_layout_t::impl
         /* Disconnect timer, since otherwise it will be destroyed
          * after the wayland display is. */
         this->timer_remove_noop.disconnect();
+        this->timer_configure_pending.disconnect();
         if (noop_output)
         {
             noop_output->destroy_wayfire_output();
@@ -950,7 +1005,14 @@ class output_layout_t::impl
 
         output_layout = wlr_output_layout_create();
 
-        on_config_reload.set_callback([=] (void*) { reconfigure_from_config(); });
+        on_config_reload.set_callback([=] (wf::signal_data_t *data)
+        {
+            if (wf::config_section_changed(data, "output") ||
+                wf::config_section_changed(data, "workarounds"))
+            {
+                reconfigure_from_config();
+            }
+        });
         get_core().connect_signal("reload-config", &on_config_reload);
 
         noop_backend = wlr_headless_backend_create(get_core().display);
@@ -1104,17 +1166,53 @@ class output_layout_t::impl
         }
 
         auto lo = new output_layout_output_t(output);
-        outputs[output] = std::unique_ptr<output_layout_output_t>(lo);
         lo->on_destroy.set_callback([output, this] (void*)
         {
             remove_output(output);
         });
 
+        if (get_core().get_current_state() != compositor_state_t::RUNNING)
+        {
+            /* At startup, all outputs are added at once anyway */
+            outputs[output] = std::unique_ptr<output_layout_output_t>(lo);
+            reconfigure_from_config();
+            return;
+        }
+
+        pending_outputs[output] = std::unique_ptr<output_layout_output_t>(lo);
+        timer_configure_pending.set_timeout(HOTPLUG_COALESCE_MS, [=] ()
+        {
+            configure_pending_outputs();
+            return false;
+        });
+    }
+
+    void configure_pending_outputs()
+    {
+        if (pending_outputs.empty())
+        {
+            return;
+        }
+
+        LOGI("configuring ", pending_outputs.size(), " new output(s)");
+        for (auto& [handle, lo] : pending_outputs)
+        {
+            outputs[handle] = std::move(lo);
+        }
+
+        pending_outputs.clear();
         reconfigure_from_config();
     }
 
     void remove_output(wlr_output *to_remove)
     {
+        if (pending_outputs.count(to_remove))
+        {
+            LOGI("remove output before it was configured: ", to_remove->name);
+            pending_outputs.erase(to_remove);
+            return;
+        }
+
         auto active_outputs = get_outputs();
         LOGI("remove output: ", to_remove->name);
 
@@ -1448,6 +1546,13 @@ class output_layout_t::impl
             }
         }
 
+        /* Only now that all outputs are in their final state, let plugins
+         * know what changed */
+        for (auto& entry : config)
+        {
+            this->outputs[entry.first]->emit_configuration_changed();
+        }
+
         get_core().output_layout->emit_signal("configuration-changed", nullptr);
 
         if (count_enabled > 0)
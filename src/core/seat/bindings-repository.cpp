@@ -1,54 +1,108 @@
 #include "bindings-repository.hpp"
 #include <wayfire/core.hpp>
+#include <wayfire/signal-definitions.hpp>
 #include <algorithm>
 
-bool wf::bindings_repository_t::handle_key(const wf::keybinding_t& pressed,
-    uint32_t mod_binding_key)
+static uint64_t combination_index(uint32_t modifiers, uint32_t code)
+{
+    return ((uint64_t)modifiers << 32) | code;
+}
+
+std::shared_ptr<const wf::bindings_repository_t::binding_matches_t<wf::key_callback>>
+wf::bindings_repository_t::lookup(const wf::keybinding_t& pressed)
 {
-    std::vector<std::function<bool()>> callbacks;
-    for (auto& binding : this->keys)
+    auto& entry = key_index[combination_index(pressed.get_modifiers(), pressed.get_key())];
+    if (!entry)
     {
-        if (binding->activated_by->get_value() == pressed)
+        auto matches = std::make_shared<binding_matches_t<key_callback>>();
+        for (auto& binding : this->keys)
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->callback;
-            callbacks.emplace_back([pressed, callback] ()
+            if (binding->activated_by->get_value() == pressed)
             {
-                return (*callback)(pressed);
-            });
+                matches->bindings.push_back(binding->callback);
+            }
         }
+
+        for (auto& binding : this->activators)
+        {
+            if (binding->activated_by->get_value().has_match(pressed))
+            {
+                matches->activators.push_back(binding->callback);
+            }
+        }
+
+        entry = std::move(matches);
     }
 
-    for (auto& binding : this->activators)
+    return entry;
+}
+
+std::shared_ptr<const wf::bindings_repository_t::binding_matches_t<wf::button_callback>>
+wf::bindings_repository_t::lookup(const wf::buttonbinding_t& pressed)
+{
+    auto& entry =
+        button_index[combination_index(pressed.get_modifiers(), pressed.get_button())];
+    if (!entry)
     {
-        if (binding->activated_by->get_value().has_match(pressed))
+        auto matches = std::make_shared<binding_matches_t<button_callback>>();
+        for (auto& binding : this->buttons)
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->callback;
-            callbacks.emplace_back([pressed, callback, mod_binding_key] ()
+            if (binding->activated_by->get_value() == pressed)
             {
-                wf::activator_data_t ev = {
-                    .source = activator_source_t::KEYBINDING,
-                    .activation_data = pressed.get_key()
-                };
-
-                if (mod_binding_key)
-                {
-                    ev.source = activator_source_t::MODIFIERBINDING;
-                    ev.activation_data = mod_binding_key;
-                }
+                matches->bindings.push_back(binding->callback);
+            }
+        }
 
-                return (*callback)(ev);
-            });
+        for (auto& binding : this->activators)
+        {
+            if (binding->activated_by->get_value().has_match(pressed))
+            {
+                matches->activators.push_back(binding->callback);
+            }
         }
+
+        entry = std::move(matches);
     }
 
+    return entry;
+}
+
+void wf::bindings_repository_t::invalidate_dispatch_index()
+{
+    key_index.clear();
+    button_index.clear();
+}
+
+bool wf::bindings_repository_t::handle_key(const wf::keybinding_t& pressed,
+    uint32_t mod_binding_key)
+{
+    /* Callbacks may add or remove bindings, but the looked up entry stays
+     * alive until we are done with it. */
+    auto matches = lookup(pressed);
+
     bool handled = false;
-    for (auto& cb : callbacks)
+    for (auto& callback : matches->bindings)
     {
-        handled |= cb();
+        handled |= (*callback)(pressed);
+    }
+
+    if (!matches->activators.empty())
+    {
+        wf::activator_data_t ev = {
+            .source = activator_source_t::KEYBINDING,
+            .activation_data = pressed.get_key()
+        };
+
+        if (mod_binding_key)
+        {
+            ev.source = activator_source_t::MODIFIERBINDING;
+            ev.activation_data = mod_binding_key;
+        }
+
+        for (auto& callback : matches->activators)
+        {
+            handled |= (*callback)(ev);
+        }
     }
 
     return handled;
@@ -77,45 +131,27 @@ bool wf::bindings_repository_t::handle_axis(uint32_t modifiers,
 
 bool wf::bindings_repository_t::handle_button(const wf::buttonbinding_t& pressed)
 {
-    std::vector<std::function<bool()>> callbacks;
-    for (auto& binding : this->buttons)
+    auto matches = lookup(pressed);
+
+    bool binding_handled = false;
+    for (auto& callback : matches->bindings)
     {
-        if (binding->activated_by->get_value() == pressed)
-        {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->callback;
-            callbacks.emplace_back([=] ()
-            {
-                return (*callback)(pressed);
-            });
-        }
+        binding_handled |= (*callback)(pressed);
     }
 
-    for (auto& binding : this->activators)
+    if (!matches->activators.empty())
     {
-        if (binding->activated_by->get_value().has_match(pressed))
+        wf::activator_data_t data = {
+            .source = activator_source_t::BUTTONBINDING,
+            .activation_data = pressed.get_button(),
+        };
+
+        for (auto& callback : matches->activators)
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->callback;
-            callbacks.emplace_back([=] ()
-            {
-                wf::activator_data_t data = {
-                    .source = activator_source_t::BUTTONBINDING,
-                    .activation_data = pressed.get_button(),
-                };
-                return (*callback)(data);
-            });
+            binding_handled |= (*callback)(data);
         }
     }
 
-    bool binding_handled = false;
-    for (auto call : callbacks)
-    {
-        binding_handled |= call();
-    }
-
     return binding_handled;
 }
 
@@ -178,6 +214,7 @@ void wf::bindings_repository_t::rem_binding(void *callback)
     erase(axes);
     erase(activators);
 
+    invalidate_dispatch_index();
     recreate_hotspots();
 }
 
@@ -198,14 +235,22 @@ void wf::bindings_repository_t::rem_binding(binding_t *binding)
     erase(axes);
     erase(activators);
 
+    invalidate_dispatch_index();
     recreate_hotspots();
 }
 
 wf::bindings_repository_t::bindings_repository_t(wf::output_t *output) :
     hotspot_mgr(output)
 {
-    on_config_reload.set_callback([=] (wf::signal_data_t*)
+    on_config_reload.set_callback([=] (wf::signal_data_t *data)
     {
+        auto ev = static_cast<wf::reload_config_signal*>(data);
+        if (ev && !ev->bindings_changed)
+        {
+            return;
+        }
+
+        invalidate_dispatch_index();
         recreate_hotspots();
     });
 
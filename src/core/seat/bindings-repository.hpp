@@ -2,6 +2,7 @@
 
 #include "wayfire/geometry.hpp"
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include <wayfire/bindings.hpp>
 #include <wayfire/config/option-wrapper.hpp>
@@ -46,9 +47,12 @@ class bindings_repository_t
     bool handle_activator(
         const std::string& activator, const wf::activator_data_t& data);
 
-    /** Erase binding of any type by callback */
+    /**
+     * Erase binding of any type by callback. Destroying the binding also
+     * removes its updated handler from the option.
+     */
     void rem_binding(void *callback);
-    /** Erase binding of any type */
+    /** Erase binding of any type, see above */
     void rem_binding(binding_t *binding);
 
     /**
@@ -58,6 +62,13 @@ class bindings_repository_t
      */
     void recreate_hotspots();
 
+    /**
+     * Drop the dispatch index. Must be called whenever bindings are added or
+     * removed, or their options change. The bindings added by the output
+     * call it themselves when their option is updated.
+     */
+    void invalidate_dispatch_index();
+
   private:
     // output_t directly pushes in the binding containers to avoid having the
     // same wrapped functions as in the output public API.
@@ -70,6 +81,38 @@ class bindings_repository_t
 
     hotspot_manager_t hotspot_mgr;
 
+    /**
+     * The bindings triggered by a given key or button combination, in the order
+     * in which they are called.
+     */
+    template<class Callback>
+    struct binding_matches_t
+    {
+        std::vector<Callback*> bindings;
+        std::vector<activator_callback*> activators;
+    };
+
+    /**
+     * The dispatch index maps a combination (modifiers in the upper 32 bits, key
+     * or button in the lower 32 bits) to the bindings it triggers. Entries are
+     * filled on the first use of the combination, so that repeated presses do not
+     * need to scan all bindings, and cleared whenever the bindings change.
+     *
+     * Entries are shared pointers so that a lookup stays valid even if a binding
+     * callback changes the bindings and thus clears the index.
+     */
+    template<class Callback>
+    using dispatch_index_t = std::unordered_map<uint64_t,
+        std::shared_ptr<const binding_matches_t<Callback>>>;
+
+    dispatch_index_t<key_callback> key_index;
+    dispatch_index_t<button_callback> button_index;
+
+    std::shared_ptr<const binding_matches_t<key_callback>> lookup(
+        const wf::keybinding_t& pressed);
+    std::shared_ptr<const binding_matches_t<button_callback>> lookup(
+        const wf::buttonbinding_t& pressed);
+
     wf::signal_connection_t on_config_reload;
     wf::wl_idle_call idle_recreate_hotspots;
 };
@@ -24,8 +24,13 @@ wf::cursor_t::cursor_t(wf::seat_t *seat)
     wlr_cursor_warp(cursor, NULL, cursor->x, cursor->y);
     init_xcursor();
 
-    config_reloaded.set_callback([=] (wf::signal_data_t*)
+    config_reloaded.set_callback([=] (wf::signal_data_t *data)
     {
+        if (!wf::config_section_changed(data, "input/cursor_"))
+        {
+            return;
+        }
+
         init_xcursor();
     });
 
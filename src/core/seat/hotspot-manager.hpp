@@ -3,6 +3,7 @@
 #include <map>
 #include "wayfire/util.hpp"
 #include <wayfire/config/types.hpp>
+#include <wayfire/config/option.hpp>
 #include <wayfire/output.hpp>
 #include <wayfire/util/log.hpp>
 
@@ -22,6 +23,17 @@ struct output_binding_t : public binding_t
 {
     wf::option_sptr_t<Option> activated_by;
     Callback *callback;
+
+    /** Registered on activated_by, if set, until the binding is removed */
+    wf::config::option_base_t::updated_callback_t on_option_updated;
+
+    ~output_binding_t()
+    {
+        if (on_option_updated)
+        {
+            activated_by->rem_updated_handler(&on_option_updated);
+        }
+    }
 };
 
 template<class Option, class Callback> using binding_container_t =
@@ -171,6 +171,7 @@ void wf::pointer_t::grab_surface(wf::scene::node_ptr node)
 void wf::pointer_t::handle_pointer_button(wlr_pointer_button_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     seat->break_mod_bindings();
     bool handled_in_binding = (mode != input_event_processing_mode_t::FULL);
 
@@ -287,12 +288,23 @@ void wf::pointer_t::handle_pointer_motion(wlr_pointer_motion_event *ev,
     /* XXX: maybe warp directly? */
     wlr_cursor_move(seat->cursor->cursor, &ev->pointer->base, ev->delta_x,
         ev->delta_y);
+
+    if (coalesce_motion && !needs_full_rate_motion())
+    {
+        // Handled in handle_pointer_frame()
+        motion_pending = true;
+        pending_motion_time = ev->time_msec;
+        return;
+    }
+
     update_cursor_position(ev->time_msec);
 }
 
 void wf::pointer_t::handle_pointer_motion_absolute(
     wlr_pointer_motion_absolute_event *ev, input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
+
     // next coordinates
     double cx, cy;
     wlr_cursor_absolute_to_layout_coords(seat->cursor->cursor, &ev->pointer->base,
@@ -313,6 +325,7 @@ void wf::pointer_t::handle_pointer_motion_absolute(
 void wf::pointer_t::handle_pointer_axis(wlr_pointer_axis_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     bool handled_in_binding = input->get_active_bindings().handle_axis(
         seat->get_modifiers(), ev);
     seat->break_mod_bindings();
@@ -351,6 +364,7 @@ void wf::pointer_t::handle_pointer_axis(wlr_pointer_axis_event *ev,
 void wf::pointer_t::handle_pointer_swipe_begin(wlr_pointer_swipe_begin_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     wlr_pointer_gestures_v1_send_swipe_begin(
         wf::get_core().protocols.pointer_gestures, seat->seat,
         ev->time_msec, ev->fingers);
@@ -359,6 +373,7 @@ void wf::pointer_t::handle_pointer_swipe_begin(wlr_pointer_swipe_begin_event *ev
 void wf::pointer_t::handle_pointer_swipe_update(
     wlr_pointer_swipe_update_event *ev, input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     wlr_pointer_gestures_v1_send_swipe_update(
         wf::get_core().protocols.pointer_gestures, seat->seat,
         ev->time_msec, ev->dx, ev->dy);
@@ -367,6 +382,7 @@ void wf::pointer_t::handle_pointer_swipe_update(
 void wf::pointer_t::handle_pointer_swipe_end(wlr_pointer_swipe_end_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     wlr_pointer_gestures_v1_send_swipe_end(
         wf::get_core().protocols.pointer_gestures, seat->seat,
         ev->time_msec, ev->cancelled);
@@ -375,6 +391,7 @@ void wf::pointer_t::handle_pointer_swipe_end(wlr_pointer_swipe_end_event *ev,
 void wf::pointer_t::handle_pointer_pinch_begin(wlr_pointer_pinch_begin_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     wlr_pointer_gestures_v1_send_pinch_begin(
         wf::get_core().protocols.pointer_gestures, seat->seat,
         ev->time_msec, ev->fingers);
@@ -383,6 +400,7 @@ void wf::pointer_t::handle_pointer_pinch_begin(wlr_pointer_pinch_begin_event *ev
 void wf::pointer_t::handle_pointer_pinch_update(
     wlr_pointer_pinch_update_event *ev, input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     wlr_pointer_gestures_v1_send_pinch_update(
         wf::get_core().protocols.pointer_gestures, seat->seat,
         ev->time_msec, ev->dx, ev->dy, ev->scale, ev->rotation);
@@ -391,6 +409,7 @@ void wf::pointer_t::handle_pointer_pinch_update(
 void wf::pointer_t::handle_pointer_pinch_end(wlr_pointer_pinch_end_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     wlr_pointer_gestures_v1_send_pinch_end(
         wf::get_core().protocols.pointer_gestures, seat->seat,
         ev->time_msec, ev->cancelled);
@@ -399,6 +418,7 @@ void wf::pointer_t::handle_pointer_pinch_end(wlr_pointer_pinch_end_event *ev,
 void wf::pointer_t::handle_pointer_hold_begin(wlr_pointer_hold_begin_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     wlr_pointer_gestures_v1_send_hold_begin(
         wf::get_core().protocols.pointer_gestures, seat->seat,
         ev->time_msec, ev->fingers);
@@ -407,6 +427,7 @@ void wf::pointer_t::handle_pointer_hold_begin(wlr_pointer_hold_begin_event *ev,
 void wf::pointer_t::handle_pointer_hold_end(wlr_pointer_hold_end_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_pending_motion(true);
     wlr_pointer_gestures_v1_send_hold_end(
         wf::get_core().protocols.pointer_gestures, seat->seat,
         ev->time_msec, ev->cancelled);
@@ -414,5 +435,86 @@ void wf::pointer_t::handle_pointer_hold_end(wlr_pointer_hold_end_event *ev,
 
 void wf::pointer_t::handle_pointer_frame()
 {
+    if (motion_pending)
+    {
+        int64_t wait = last_motion_update + get_motion_interval() - get_current_time();
+        if (wait > 0)
+        {
+            // The frame is sent together with the motion
+            if (!pending_motion_timer.is_connected())
+            {
+                pending_motion_timer.set_timeout(wait, [=] ()
+                {
+                    flush_pending_motion(true);
+                    return false;
+                });
+            }
+
+            return;
+        }
+
+        flush_pending_motion(false);
+    }
+
     wlr_seat_pointer_notify_frame(seat->seat);
 }
+
+bool wf::pointer_t::needs_full_rate_motion()
+{
+    auto surface = seat->seat->pointer_state.focused_surface;
+    if (!surface)
+    {
+        return false;
+    }
+
+    if (wlr_pointer_constraints_v1_constraint_for_surface(
+        wf::get_core().protocols.pointer_constraints, surface, seat->seat))
+    {
+        return true;
+    }
+
+    auto client = wl_resource_get_client(surface->resource);
+    wlr_relative_pointer_v1 *relative;
+    wl_list_for_each(relative,
+        &wf::get_core().protocols.relative_pointer->relative_pointers, link)
+    {
+        if ((relative->seat == seat->seat) &&
+            (wl_resource_get_client(relative->resource) == client))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int64_t wf::pointer_t::get_motion_interval()
+{
+    auto gc     = seat->cursor->get_cursor_position();
+    auto output = wf::get_core().output_layout->get_output_at(gc.x, gc.y);
+    if (!output || (output->handle->refresh <= 0))
+    {
+        // Assume 60Hz if the refresh rate is unknown
+        return 16;
+    }
+
+    // refresh is in mHz
+    return std::max(1, 1000000 / output->handle->refresh);
+}
+
+void wf::pointer_t::flush_pending_motion(bool send_frame)
+{
+    if (!motion_pending)
+    {
+        return;
+    }
+
+    motion_pending = false;
+    pending_motion_timer.disconnect();
+    last_motion_update = get_current_time();
+    update_cursor_position(pending_motion_time);
+    if (send_frame)
+    {
+        wlr_seat_pointer_notify_frame(seat->seat);
+    }
+}
@@ -85,6 +85,16 @@ class pointer_t
      */
     void update_cursor_position(int64_t time_msec, bool real_update = true);
 
+    /**
+     * Process the motion deferred by input/coalesce_pointer_motion now, if
+     * there is any. Called before any other input event, so that it is
+     * handled with an up-to-date pointer focus.
+     *
+     * @param send_frame Whether to also send the frame event, which was held
+     *   back when the motion was deferred.
+     */
+    void flush_pending_motion(bool send_frame);
+
   private:
     nonstd::observer_ptr<wf::input_manager_t> input;
     nonstd::observer_ptr<seat_t> seat;
@@ -130,6 +140,29 @@ class pointer_t
      * active grab or the focused surface.
      */
     void send_motion(uint32_t time_msec);
+
+    /**
+     * Motion coalescing: with input/coalesce_pointer_motion, relative motion
+     * only moves the cursor immediately. Hit-testing, focus updates and sending
+     * motion to the focused surface and grabs happen at most once per refresh
+     * of the output under the cursor. Surfaces using relative motion or
+     * pointer constraints get all events and frames without delay.
+     */
+    wf::option_wrapper_t<bool> coalesce_motion{"input/coalesce_pointer_motion"};
+    bool motion_pending = false;
+    uint32_t pending_motion_time = 0;
+    int64_t last_motion_update = 0;
+    wf::wl_timer pending_motion_timer;
+
+    /** @return The refresh interval of the output under the cursor, in ms. */
+    int64_t get_motion_interval();
+
+    /**
+     * @return Whether the focused surface should get pointer motion without
+     *   coalescing, because it uses relative pointer motion or has an active
+     *   pointer constraint.
+     */
+    bool needs_full_rate_motion();
 };
 }
 
@@ -283,6 +283,7 @@ void wf::tablet_t::handle_tip(wlr_tablet_tool_tip_event *ev,
 {
     auto& input = wf::get_core_impl().input;
     auto& seat  = wf::get_core_impl().seat;
+    seat->lpointer->flush_pending_motion(true);
     seat->break_mod_bindings();
 
     bool handled_in_binding = false;
@@ -321,6 +322,7 @@ void wf::tablet_t::handle_axis(wlr_tablet_tool_axis_event *ev,
     input_event_processing_mode_t mode)
 {
     auto& input = wf::get_core_impl().input;
+    wf::get_core_impl().seat->lpointer->flush_pending_motion(true);
     std::string motion_mode = wf::option_wrapper_t<std::string>(
         "input/tablet_motion_mode");
 
@@ -370,6 +372,8 @@ void wf::tablet_t::handle_axis(wlr_tablet_tool_axis_event *ev,
 void wf::tablet_t::handle_button(wlr_tablet_tool_button_event *ev,
     input_event_processing_mode_t mode)
 {
+    wf::get_core_impl().seat->lpointer->flush_pending_motion(true);
+
     /* Pass to the tool */
     ensure_tool(ev->tool)->handle_button(ev);
 }
@@ -377,9 +381,9 @@ void wf::tablet_t::handle_button(wlr_tablet_tool_button_event *ev,
 void wf::tablet_t::handle_proximity(wlr_tablet_tool_proximity_event *ev,
     input_event_processing_mode_t mode)
 {
-    ensure_tool(ev->tool)->handle_proximity(ev);
-
     auto& impl = wf::get_core_impl();
+    impl.seat->lpointer->flush_pending_motion(true);
+    ensure_tool(ev->tool)->handle_proximity(ev);
 
     /* Show appropriate cursor */
     if (ev->state == WLR_TABLET_TOOL_PROXIMITY_OUT)
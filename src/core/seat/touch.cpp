@@ -5,6 +5,7 @@
 #include "core/seat/seat.hpp"
 #include "touch.hpp"
 #include "cursor.hpp"
+#include "pointer.hpp"
 #include "input-manager.hpp"
 #include "../core-impl.hpp"
 #include "wayfire/core.hpp"
@@ -23,6 +24,7 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
     // connect handlers
     on_down.set_callback([=] (void *data)
     {
+        wf::get_core_impl().seat->lpointer->flush_pending_motion(true);
         auto ev   = static_cast<wlr_touch_down_event*>(data);
         auto mode = emit_device_event_signal("touch_down", ev);
 
@@ -40,6 +42,7 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
 
     on_up.set_callback([=] (void *data)
     {
+        wf::get_core_impl().seat->lpointer->flush_pending_motion(true);
         auto ev   = static_cast<wlr_touch_up_event*>(data);
         auto mode = emit_device_event_signal("touch_up", ev);
         handle_touch_up(ev->touch_id, ev->time_msec, mode);
@@ -50,6 +53,7 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
 
     on_motion.set_callback([=] (void *data)
     {
+        wf::get_core_impl().seat->lpointer->flush_pending_motion(true);
         auto ev   = static_cast<wlr_touch_motion_event*>(data);
         auto mode = emit_device_event_signal("touch_motion", ev);
 
@@ -0,0 +1,66 @@
+#include <wayfire/startup-timeline.hpp>
+#include <wayfire/util/log.hpp>
+#include <iomanip>
+#include <sstream>
+#include "core-impl.hpp"
+
+/* Initialized before main(), close enough to the start of the process */
+static const auto process_start = std::chrono::steady_clock::now();
+static std::vector<wf::startup_event_t> timeline;
+static bool startup_finished = false;
+
+static double ms_between(std::chrono::steady_clock::time_point a,
+    std::chrono::steady_clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+wf::startup_phase_t::startup_phase_t(std::string phase, std::string detail)
+{
+    this->phase  = std::move(phase);
+    this->detail = std::move(detail);
+    this->start  = std::chrono::steady_clock::now();
+}
+
+wf::startup_phase_t::~startup_phase_t()
+{
+    if (startup_finished)
+    {
+        return;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    timeline.push_back({phase, detail, ms_between(process_start, start),
+        ms_between(start, end)});
+}
+
+const std::vector<wf::startup_event_t>& wf::get_startup_timeline()
+{
+    return timeline;
+}
+
+void wf::finish_startup_timeline(bool print)
+{
+    auto now = std::chrono::steady_clock::now();
+    timeline.push_back({"startup", "", 0, ms_between(process_start, now)});
+    startup_finished = true;
+
+    if (!print)
+    {
+        return;
+    }
+
+    LOGI("Startup timeline (start, duration, phase):");
+    for (auto& ev : timeline)
+    {
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(2) << std::setw(9) << ev.start_ms <<
+            "ms " << std::setw(9) << ev.duration_ms << "ms  " << ev.phase;
+        if (!ev.detail.empty())
+        {
+            line << " (" << ev.detail << ")";
+        }
+
+        LOGI(line.str());
+    }
+}
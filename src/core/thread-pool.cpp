@@ -0,0 +1,212 @@
+#include <wayfire/thread-pool.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/util/log.hpp>
+#include <wayland-server.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+wf::thread_pool_t& wf::thread_pool_t::get()
+{
+    static thread_pool_t pool;
+    return pool;
+}
+
+wf::thread_pool_t::~thread_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        stopping = true;
+    }
+
+    tasks_cv.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    /* The event loop is already gone at this point, so we do not remove the
+     * event source, just close the fd. */
+    if (completion_fd >= 0)
+    {
+        close(completion_fd);
+    }
+}
+
+void wf::thread_pool_t::ensure_started()
+{
+    if (!workers.empty())
+    {
+        return;
+    }
+
+    // The thread calling parallel_for() participates as well
+    size_t num = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    completion_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    completion_source = wl_event_loop_add_fd(wf::get_core().ev_loop,
+        completion_fd, WL_EVENT_READABLE, handle_completions, this);
+
+    LOGD("Starting thread pool with ", num, " workers");
+    for (size_t i = 0; i < num; i++)
+    {
+        workers.emplace_back([=] () { worker_loop(); });
+    }
+}
+
+size_t wf::thread_pool_t::get_num_workers()
+{
+    ensure_started();
+    return workers.size();
+}
+
+void wf::thread_pool_t::worker_loop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex);
+            tasks_cv.wait(lock, [=] { return stopping || !tasks.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+void wf::thread_pool_t::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        tasks.push_back(std::move(task));
+    }
+
+    tasks_cv.notify_one();
+}
+
+namespace
+{
+/** State shared by all threads working on one parallel_for() */
+struct parallel_batch_t
+{
+    const std::function<void(size_t, size_t)> *func;
+    size_t count;
+    size_t grain;
+    size_t num_chunks;
+
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> finished_chunks{0};
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+
+    void run()
+    {
+        size_t chunk;
+        while ((chunk = next_chunk.fetch_add(1)) < num_chunks)
+        {
+            size_t start = chunk * grain;
+            (*func)(start, std::min(count, start + grain));
+            if (finished_chunks.fetch_add(1) + 1 == num_chunks)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done_cv.notify_all();
+            }
+        }
+    }
+};
+}
+
+void wf::thread_pool_t::parallel_for(size_t count, size_t grain,
+    const std::function<void(size_t, size_t)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grain = std::max<size_t>(grain, 1);
+    const size_t num_chunks = (count + grain - 1) / grain;
+    if (num_chunks == 1)
+    {
+        func(0, count);
+        return;
+    }
+
+    ensure_started();
+
+    auto batch = std::make_shared<parallel_batch_t>();
+    batch->func  = &func;
+    batch->count = count;
+    batch->grain = grain;
+    batch->num_chunks = num_chunks;
+
+    /* Helpers which start after all chunks are taken return immediately, so
+     * they never touch func after we have returned. */
+    const size_t num_helpers = std::min(num_chunks - 1, workers.size());
+    for (size_t i = 0; i < num_helpers; i++)
+    {
+        enqueue([batch] () { batch->run(); });
+    }
+
+    batch->run();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done_cv.wait(lock, [&] { return batch->finished_chunks == num_chunks; });
+}
+
+void wf::thread_pool_t::submit(std::function<void()> job, std::function<void()> done)
+{
+    ensure_started();
+    enqueue([=] ()
+    {
+        job();
+        if (done)
+        {
+            {
+                std::lock_guard<std::mutex> lock(completions_mutex);
+                completions.push_back(done);
+            }
+
+            uint64_t one = 1;
+            if (write(completion_fd, &one, sizeof(one)) < 0)
+            {
+                LOGE("Failed to signal thread pool completion");
+            }
+        }
+    });
+}
+
+int wf::thread_pool_t::handle_completions(int fd, uint32_t mask, void *data)
+{
+    auto pool = static_cast<thread_pool_t*>(data);
+
+    uint64_t value;
+    if (read(fd, &value, sizeof(value)) < 0)
+    {
+        return 0;
+    }
+
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(pool->completions_mutex);
+        std::swap(ready, pool->completions);
+    }
+
+    for (auto& callback : ready)
+    {
+        callback();
+    }
+
+    return 0;
+}
@@ -1,33 +1,113 @@
 #include <vector>
+#include <map>
 #include "wayfire/debug.hpp"
 #include <string>
 #include <wayfire/config/file.hpp>
+#include <wayfire/config/types.hpp>
 #include <wayfire/config-backend.hpp>
 #include <wayfire/plugin.hpp>
 #include <wayfire/core.hpp>
+#include <wayfire/signal-definitions.hpp>
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 #include <sys/inotify.h>
 #include <unistd.h>
 
-#define INOT_BUF_SIZE (sizeof(inotify_event) + NAME_MAX + 1)
+#define INOT_BUF_SIZE (16 * (sizeof(inotify_event) + NAME_MAX + 1))
+
+/**
+ * Time to wait after the last change to the config file before reloading it,
+ * so that a burst of writes results in a single reload.
+ */
+static const int RELOAD_DEBOUNCE_MS = 100;
 
 static std::string config_dir, config_file;
 wf::config::config_manager_t *cfg_manager;
 
+static int inotify_fd;
 static int wd_cfg_file;
+static wl_event_source *reload_timer;
+
+/** Hash of the config file contents as of the last reload */
+static size_t last_config_hash;
 
 static void readd_watch(int fd)
 {
-    inotify_add_watch(fd, config_dir.c_str(), IN_CREATE);
-    wd_cfg_file = inotify_add_watch(fd, config_file.c_str(), IN_MODIFY);
+    // Editors and deployment tools often write a new file and rename it over
+    // the old one, which we see as IN_MOVED_TO in the directory.
+    inotify_add_watch(fd, config_dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    wd_cfg_file = inotify_add_watch(fd, config_file.c_str(), IN_CLOSE_WRITE);
+}
+
+static size_t hash_config_file()
+{
+    std::ifstream file(config_file);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return std::hash<std::string>{}(contents.str());
 }
 
 static void reload_config(int fd)
 {
+    last_config_hash = hash_config_file();
     wf::config::load_configuration_options_from_file(*cfg_manager, config_file);
     readd_watch(fd);
 }
 
+/** Values of all options, keyed by section/option */
+using option_snapshot_t = std::map<std::string, std::string>;
+
+static option_snapshot_t snapshot_options()
+{
+    option_snapshot_t snapshot;
+    for (auto& section : cfg_manager->get_all_sections())
+    {
+        for (auto& opt : section->get_registered_options())
+        {
+            snapshot[section->get_name() + "/" + opt->get_name()] =
+                opt->get_value_str();
+        }
+    }
+
+    return snapshot;
+}
+
+static bool is_binding_option(const std::string& name)
+{
+    using namespace wf::config;
+    auto opt = cfg_manager->get_option(name);
+    return std::dynamic_pointer_cast<option_t<wf::keybinding_t>>(opt) ||
+           std::dynamic_pointer_cast<option_t<wf::buttonbinding_t>>(opt) ||
+           std::dynamic_pointer_cast<option_t<wf::activatorbinding_t>>(opt);
+}
+
+/** Fill @data with the differences between the two snapshots. */
+static void diff_options(const option_snapshot_t& before,
+    const option_snapshot_t& after, wf::reload_config_signal& data)
+{
+    for (auto& [name, value] : after)
+    {
+        auto it = before.find(name);
+        if ((it == before.end()) || (it->second != value))
+        {
+            data.changed_options.insert(name);
+            data.bindings_changed |= is_binding_option(name);
+        }
+    }
+
+    for (auto& [name, value] : before)
+    {
+        if (!after.count(name))
+        {
+            // We cannot tell the type of a removed option anymore
+            data.changed_options.insert(name);
+            data.bindings_changed = true;
+        }
+    }
+}
+
 static int handle_config_updated(int fd, uint32_t mask, void *data)
 {
     if ((mask & WL_EVENT_READABLE) == 0)
@@ -52,7 +132,7 @@ static int handle_config_updated(int fd, uint32_t mask, void *data)
 
     const auto last_slash = config_file.find_last_of('/');
     const auto cfg_file_basename = (last_slash == std::string::npos) ?
-        config_file : config_file.substr(last_slash);
+        config_file : config_file.substr(last_slash + 1);
 
     for (char *ptr = buf;
          ptr < (buf + len);
@@ -61,23 +141,45 @@ static int handle_config_updated(int fd, uint32_t mask, void *data)
         event = reinterpret_cast<inotify_event*>(ptr);
         // We reload in two main cases:
         //
-        // - Config file itself was modified
-        // - Config file was created inside parent directory
-        should_reload |=
-            (event->wd == wd_cfg_file) || (cfg_file_basename == event->name);
+        // - Config file itself was written and closed
+        // - Config file was written or moved into the parent directory
+        should_reload |= (event->wd == wd_cfg_file) ||
+            (event->len && (cfg_file_basename == event->name));
     }
 
+    readd_watch(fd);
     if (should_reload)
     {
-        LOGD("Reloading configuration file");
+        wl_event_source_timer_update(reload_timer, RELOAD_DEBOUNCE_MS);
+    }
 
-        reload_config(fd);
-        wf::get_core().emit_signal("reload-config", nullptr);
-    } else
+    return 0;
+}
+
+static int handle_reload_timer(void*)
+{
+    size_t hash = hash_config_file();
+    if (hash == last_config_hash)
+    {
+        LOGD("Configuration file contents did not change, skipping reload");
+        return 0;
+    }
+
+    LOGD("Reloading configuration file");
+
+    auto before = snapshot_options();
+    reload_config(inotify_fd);
+
+    wf::reload_config_signal data;
+    diff_options(before, snapshot_options(), data);
+    if (data.changed_options.empty())
     {
-        readd_watch(fd);
+        LOGD("No options changed");
+        return 0;
     }
 
+    LOGD(data.changed_options.size(), " options changed");
+    wf::get_core().emit_signal("reload-config", &data);
     return 0;
 }
 
@@ -100,11 +202,17 @@ class dynamic_ini_config_t : public wf::config_backend_t
         config = wf::config::build_configuration(
             get_xml_dirs(), SYSCONFDIR "/wayfire/defaults.ini", config_file);
 
-        int inotify_fd = inotify_init1(IN_CLOEXEC);
+        const auto last_slash = config_file.find_last_of('/');
+        config_dir = (last_slash == std::string::npos) ?
+            "." : config_file.substr(0, std::max<size_t>(last_slash, 1));
+
+        inotify_fd = inotify_init1(IN_CLOEXEC);
         reload_config(inotify_fd);
 
-        wl_event_loop_add_fd(wl_display_get_event_loop(display),
-            inotify_fd, WL_EVENT_READABLE, handle_config_updated, NULL);
+        auto loop = wl_display_get_event_loop(display);
+        reload_timer = wl_event_loop_add_timer(loop, handle_reload_timer, NULL);
+        wl_event_loop_add_fd(loop, inotify_fd, WL_EVENT_READABLE,
+            handle_config_updated, NULL);
     }
 
     std::string choose_cfg_file(const std::string& cmdline_cfg_file)
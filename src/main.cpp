@@ -18,6 +18,7 @@
 #include "output/plugin-loader.hpp"
 #include "core/core-impl.hpp"
 #include "wayfire/output.hpp"
+#include "wayfire/startup-timeline.hpp"
 
 static void print_version()
 {
@@ -39,6 +40,8 @@ static void print_help()
         " -D,  --damage-debug      enable additional debug for damaged regions" <<
         std::endl;
     std::cout << " -R,  --damage-rerender   rerender damaged regions" << std::endl;
+    std::cout << " -P,  --profile-startup   print how long each startup step took" <<
+        std::endl;
     std::cout << " -v,  --version           print version and exit" << std::endl;
     exit(0);
 }
@@ -224,6 +227,7 @@ int main(int argc, char *argv[])
         {"debug", optional_argument, NULL, 'd'},
         {"damage-debug", no_argument, NULL, 'D'},
         {"damage-rerender", no_argument, NULL, 'R'},
+        {"profile-startup", no_argument, NULL, 'P'},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         {0, 0, NULL, 0}
@@ -234,7 +238,7 @@ int main(int argc, char *argv[])
     std::vector<std::string> extended_debug_categories;
 
     int c, i;
-    while ((c = getopt_long(argc, argv, "c:B:d::DhRv", opts, &i)) != -1)
+    while ((c = getopt_long(argc, argv, "c:B:d::DhPRv", opts, &i)) != -1)
     {
         switch (c)
         {
@@ -254,6 +258,10 @@ int main(int argc, char *argv[])
             runtime_config.no_damage_track = true;
             break;
 
+          case 'P':
+            runtime_config.profile_startup = true;
+            break;
+
           case 'h':
             print_help();
             break;
@@ -313,6 +321,8 @@ int main(int argc, char *argv[])
     /** TODO: move this to core_impl constructor */
     core.display = display;
     core.ev_loop = wl_display_get_event_loop(core.display);
+
+    auto backend_phase = std::make_unique<wf::startup_phase_t>("backend-create");
     core.backend = wlr_backend_autocreate(core.display);
 
     int drm_fd = wlr_backend_get_drm_fd(core.backend);
@@ -339,6 +349,7 @@ int main(int argc, char *argv[])
     assert(core.allocator);
     core.egl = wlr_gles2_renderer_get_egl(core.renderer);
     assert(core.egl);
+    backend_phase.reset();
 
     if (!drop_permissions())
     {
@@ -348,6 +359,7 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    auto config_phase = std::make_unique<wf::startup_phase_t>("config");
     auto backend = load_backend(config_backend);
     if (!backend)
     {
@@ -360,7 +372,12 @@ int main(int argc, char *argv[])
     LOGD("Using configuration backend: ", config_backend);
     core.config_backend = std::unique_ptr<wf::config_backend_t>(backend);
     core.config_backend->init(display, core.config, config_file);
-    core.init();
+    config_phase.reset();
+
+    {
+        wf::startup_phase_t phase{"core-init"};
+        core.init();
+    }
 
     auto socket = choose_socket(core.display);
     if (!socket)
@@ -372,6 +389,7 @@ int main(int argc, char *argv[])
 
     core.wayland_display = socket.value();
     LOGI("Using socket name ", core.wayland_display);
+    auto start_phase = std::make_unique<wf::startup_phase_t>("backend-start");
     if (!wlr_backend_start(core.backend))
     {
         LOGE("Failed to initialize backend, exiting");
@@ -381,6 +399,7 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    start_phase.reset();
     setenv("WAYLAND_DISPLAY", core.wayland_display.c_str(), 1);
     core.post_init();
 
@@ -0,0 +1,217 @@
+#include <wayfire/animation-scheduler.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/render-manager.hpp>
+#include <algorithm>
+#include <chrono>
+
+using scheduler_clock = std::chrono::steady_clock;
+
+namespace wf
+{
+struct scheduled_animation_t
+{
+    const void *owner;
+    std::string name;
+    animation_scheduler_t::step_t step;
+
+    uint32_t frames = 0;
+    scheduler_clock::time_point added;
+    scheduler_clock::time_point last_step;
+    double max_frame_gap_ms = 0;
+    double max_step_us = 0;
+};
+
+class animation_scheduler_t::impl
+{
+  public:
+    wf::output_t *output;
+    /* Removed animations are left as empty entries while stepping, and erased
+     * after the step is over. */
+    std::vector<std::unique_ptr<scheduled_animation_t>> animations;
+    /* Animations removed while stepping, kept alive until the step is over */
+    std::vector<std::unique_ptr<scheduled_animation_t>> retired;
+    bool stepping = false;
+    bool hook_set = false;
+
+    wf::effect_hook_t pre_hook = [=] () { step_all(); };
+
+    void step_all()
+    {
+        stepping = true;
+        const size_t count = animations.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            auto anim = animations[i].get();
+            if (!anim)
+            {
+                continue;
+            }
+
+            auto start = scheduler_clock::now();
+            if (anim->frames > 0)
+            {
+                anim->max_frame_gap_ms = std::max(anim->max_frame_gap_ms,
+                    std::chrono::duration<double, std::milli>(
+                        start - anim->last_step).count());
+            }
+
+            /* The step may remove or replace the animation itself */
+            bool running = anim->step();
+            if (animations[i].get() != anim)
+            {
+                continue;
+            }
+
+            anim->last_step = scheduler_clock::now();
+            anim->max_step_us = std::max(anim->max_step_us,
+                std::chrono::duration<double, std::micro>(
+                    anim->last_step - start).count());
+            ++anim->frames;
+
+            if (!running)
+            {
+                retire(animations[i]);
+            }
+        }
+
+        stepping = false;
+        retired.clear();
+        compact();
+    }
+
+    void retire(std::unique_ptr<scheduled_animation_t>& anim)
+    {
+        if (stepping)
+        {
+            retired.push_back(std::move(anim));
+        }
+
+        anim = nullptr;
+    }
+
+    void compact()
+    {
+        auto it = std::remove(animations.begin(), animations.end(), nullptr);
+        animations.erase(it, animations.end());
+        update_hook();
+    }
+
+    void update_hook()
+    {
+        if (animations.empty() && hook_set)
+        {
+            output->render->rem_effect(&pre_hook);
+            hook_set = false;
+        } else if (!animations.empty() && !hook_set)
+        {
+            output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+            output->render->schedule_redraw();
+            hook_set = true;
+        }
+    }
+
+    std::unique_ptr<scheduled_animation_t> *find(const void *owner)
+    {
+        for (auto& anim : animations)
+        {
+            if (anim && (anim->owner == owner))
+            {
+                return &anim;
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+struct animation_scheduler_data_t : public wf::custom_data_t
+{
+    std::unique_ptr<animation_scheduler_t> scheduler;
+};
+
+animation_scheduler_t& animation_scheduler_t::get(wf::output_t *output)
+{
+    auto data = output->get_data_safe<animation_scheduler_data_t>();
+    if (!data->scheduler)
+    {
+        data->scheduler = std::make_unique<animation_scheduler_t>(output);
+    }
+
+    return *data->scheduler;
+}
+
+animation_scheduler_t::animation_scheduler_t(wf::output_t *output)
+{
+    this->priv = std::make_unique<impl>();
+    priv->output = output;
+}
+
+/* The scheduler is destroyed together with the output, when the effect hooks
+ * are already gone. */
+animation_scheduler_t::~animation_scheduler_t() = default;
+
+void animation_scheduler_t::add(const void *owner, std::string name, step_t step)
+{
+    auto anim = std::make_unique<scheduled_animation_t>();
+    anim->owner = owner;
+    anim->name  = std::move(name);
+    anim->step  = std::move(step);
+    anim->added = scheduler_clock::now();
+
+    if (auto existing = priv->find(owner))
+    {
+        priv->retire(*existing);
+        *existing = std::move(anim);
+    } else
+    {
+        priv->animations.push_back(std::move(anim));
+    }
+
+    priv->update_hook();
+}
+
+void animation_scheduler_t::remove(const void *owner)
+{
+    auto existing = priv->find(owner);
+    if (!existing)
+    {
+        return;
+    }
+
+    priv->retire(*existing);
+    if (!priv->stepping)
+    {
+        priv->compact();
+    }
+}
+
+bool animation_scheduler_t::is_running() const
+{
+    return std::any_of(priv->animations.begin(), priv->animations.end(),
+        [] (const auto& anim) { return anim != nullptr; });
+}
+
+std::vector<animation_info_t> animation_scheduler_t::list() const
+{
+    auto now = scheduler_clock::now();
+    std::vector<animation_info_t> result;
+    for (auto& anim : priv->animations)
+    {
+        if (!anim)
+        {
+            continue;
+        }
+
+        result.push_back({
+            .name = anim->name,
+            .frames     = anim->frames,
+            .running_ms = std::chrono::duration<double, std::milli>(
+                now - anim->added).count(),
+            .max_frame_gap_ms = anim->max_frame_gap_ms,
+            .max_step_us = anim->max_step_us,
+        });
+    }
+
+    return result;
+}
+}
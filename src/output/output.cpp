@@ -552,11 +552,18 @@ template<class Option, class Callback>
 static wf::binding_t *push_binding(
     binding_container_t<Option, Callback>& bindings,
     option_sptr_t<Option> opt,
-    Callback *callback)
+    Callback *callback,
+    wf::config::option_base_t::updated_callback_t on_option_updated = nullptr)
 {
     auto bnd = std::make_unique<output_binding_t<Option, Callback>>();
     bnd->activated_by = opt;
     bnd->callback     = callback;
+    if (on_option_updated)
+    {
+        bnd->on_option_updated = std::move(on_option_updated);
+        opt->add_updated_handler(&bnd->on_option_updated);
+    }
+
     bindings.emplace_back(std::move(bnd));
 
     return bindings.back().get();
@@ -565,7 +572,12 @@ static wf::binding_t *push_binding(
 binding_t*output_impl_t::add_key(option_sptr_t<keybinding_t> key,
     wf::key_callback *callback)
 {
-    return push_binding(this->bindings->keys, key, callback);
+    auto result = push_binding(this->bindings->keys, key, callback, [=] ()
+    {
+        this->bindings->invalidate_dispatch_index();
+    });
+    this->bindings->invalidate_dispatch_index();
+    return result;
 }
 
 binding_t*output_impl_t::add_axis(option_sptr_t<keybinding_t> axis,
@@ -577,13 +589,23 @@ binding_t*output_impl_t::add_axis(option_sptr_t<keybinding_t> axis,
 binding_t*output_impl_t::add_button(option_sptr_t<buttonbinding_t> button,
     wf::button_callback *callback)
 {
-    return push_binding(this->bindings->buttons, button, callback);
+    auto result = push_binding(this->bindings->buttons, button, callback, [=] ()
+    {
+        this->bindings->invalidate_dispatch_index();
+    });
+    this->bindings->invalidate_dispatch_index();
+    return result;
 }
 
 binding_t*output_impl_t::add_activator(
     option_sptr_t<activatorbinding_t> activator, wf::activator_callback *callback)
 {
-    auto result = push_binding(this->bindings->activators, activator, callback);
+    auto result = push_binding(this->bindings->activators, activator, callback, [=] ()
+    {
+        this->bindings->invalidate_dispatch_index();
+        this->bindings->recreate_hotspots();
+    });
+    this->bindings->invalidate_dispatch_index();
     this->bindings->recreate_hotspots();
     return result;
 }
@@ -3,6 +3,7 @@
 #include <set>
 #include <memory>
 #include <filesystem>
+#include <chrono>
 #include <dlfcn.h>
 
 #include "plugin-loader.hpp"
@@ -10,6 +11,7 @@
 #include "wayfire/output.hpp"
 #include "../core/wm.hpp"
 #include "wayfire/core.hpp"
+#include "wayfire/startup-timeline.hpp"
 #include <wayfire/util/log.hpp>
 
 
@@ -18,8 +20,11 @@ plugin_manager::plugin_manager(wf::output_t *o)
     this->output = o;
     this->plugins_opt.load_option("core/plugins");
 
-    reload_dynamic_plugins();
-    load_static_plugins();
+    {
+        wf::startup_phase_t phase{"plugins", output->to_string()};
+        reload_dynamic_plugins();
+        load_static_plugins();
+    }
 
     this->plugins_opt.set_callback([=] ()
     {
@@ -60,6 +65,13 @@ void plugin_manager::init_plugin(wayfire_plugin& p)
     p->init();
 }
 
+static double ms_since(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> d =
+        std::chrono::steady_clock::now() - start;
+    return d.count();
+}
+
 void plugin_manager::destroy_plugin(wayfire_plugin& p)
 {
     p->fini();
@@ -70,10 +82,10 @@ void plugin_manager::destroy_plugin(wayfire_plugin& p)
     auto handle = p->handle;
     p.reset();
 
-    /* dlopen()/dlclose() do reference counting, so we should close the plugin
-     * as many times as we opened it.
+    /* The registry holds a single dlopen() reference for all instances of a
+     * plugin, and closes it when the last instance is gone.
      *
-     * We also need to close the handle after deallocating the plugin, otherwise
+     * We need to close the handle after deallocating the plugin, otherwise
      * we unload its destructor before calling it.
      *
      * Note however, that dlclose() is merely a "statement of intent" as per
@@ -89,7 +101,7 @@ void plugin_manager::destroy_plugin(wayfire_plugin& p)
      * */
     if (handle)
     {
-        dlclose(handle);
+        wf::plugin_registry_t::get().release(handle);
     }
 }
 
@@ -137,27 +149,25 @@ std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path)
     return {handle, new_instance_func_ptr};
 }
 
-wayfire_plugin plugin_manager::load_plugin_from_file(std::string path)
+wf::plugin_registry_t& wf::plugin_registry_t::get()
 {
-    auto [handle, new_instance_func_ptr] = wf::get_new_instance_handle(path);
-
-    if (new_instance_func_ptr)
-    {
-        auto new_instance_func =
-            wf::union_cast<void*, wayfire_plugin_load_func>(new_instance_func_ptr);
-
-        auto ptr = wayfire_plugin(new_instance_func());
-        ptr->handle = handle;
-
-        return ptr;
-    }
+    static plugin_registry_t registry;
+    return registry;
+}
 
-    return nullptr;
+wf::plugin_registry_t::plugin_registry_t()
+{
+    plugins_opt.load_option("core/plugins");
 }
 
-void plugin_manager::reload_dynamic_plugins()
+const std::vector<std::string>& wf::plugin_registry_t::get_plugin_list()
 {
     std::string plugin_list = plugins_opt;
+    if (resolved && (plugin_list == resolved_opt_value))
+    {
+        return resolved_plugins;
+    }
+
     if (plugin_list == "none")
     {
         LOGE("No plugins specified in the config file, or config file is "
@@ -166,10 +176,9 @@ void plugin_manager::reload_dynamic_plugins()
     }
 
     std::stringstream stream(plugin_list);
-    std::vector<std::string> next_plugins;
-
     std::vector<std::string> plugin_paths = wf::get_plugin_paths();
 
+    resolved_plugins.clear();
     std::string plugin_name;
     while (stream >> plugin_name)
     {
@@ -179,7 +188,7 @@ void plugin_manager::reload_dynamic_plugins()
                 wf::get_plugin_path_for_name(plugin_paths, plugin_name);
             if (plugin_path)
             {
-                next_plugins.push_back(plugin_path.value());
+                resolved_plugins.push_back(plugin_path.value());
             } else
             {
                 LOGE("Failed to load plugin \"", plugin_name, "\". ",
@@ -189,6 +198,61 @@ void plugin_manager::reload_dynamic_plugins()
         }
     }
 
+    resolved_opt_value = plugin_list;
+    resolved = true;
+    return resolved_plugins;
+}
+
+wayfire_plugin wf::plugin_registry_t::create_instance(const std::string& path)
+{
+    auto it = plugins.find(path);
+    if (it == plugins.end())
+    {
+        wf::startup_phase_t phase{"plugin-open", path};
+        auto start = std::chrono::steady_clock::now();
+        auto [handle, new_instance_func_ptr] = wf::get_new_instance_handle(path);
+        if (!new_instance_func_ptr)
+        {
+            return nullptr;
+        }
+
+        auto new_instance_func =
+            wf::union_cast<void*, wayfire_plugin_load_func>(new_instance_func_ptr);
+        it = plugins.emplace(path, entry_t{handle, new_instance_func, 0}).first;
+        handle_to_path[handle] = path;
+        LOGD("Opened plugin ", path, " in ", ms_since(start), "ms");
+    }
+
+    auto ptr = wayfire_plugin(it->second.new_instance());
+    ptr->handle = it->second.handle;
+    ++it->second.refcount;
+
+    return ptr;
+}
+
+void wf::plugin_registry_t::release(void *handle)
+{
+    auto it = handle_to_path.find(handle);
+    if (it == handle_to_path.end())
+    {
+        return;
+    }
+
+    auto& entry = plugins[it->second];
+    if (--entry.refcount > 0)
+    {
+        return;
+    }
+
+    plugins.erase(it->second);
+    handle_to_path.erase(it);
+    dlclose(handle);
+}
+
+void plugin_manager::reload_dynamic_plugins()
+{
+    const auto& next_plugins = wf::plugin_registry_t::get().get_plugin_list();
+
     /* erase plugins that have been removed from the config */
     auto it = loaded_plugins.begin();
     while (it != loaded_plugins.end())
@@ -214,20 +278,33 @@ void plugin_manager::reload_dynamic_plugins()
     }
 
     /* load new plugins */
-    for (auto plugin : next_plugins)
+    auto start = std::chrono::steady_clock::now();
+    int count  = 0;
+    for (auto& plugin : next_plugins)
     {
         if (loaded_plugins.count(plugin))
         {
             continue;
         }
 
-        auto ptr = load_plugin_from_file(plugin);
+        wf::startup_phase_t phase{"plugin-init", plugin + " on " + output->to_string()};
+        auto plugin_start = std::chrono::steady_clock::now();
+        auto ptr = wf::plugin_registry_t::get().create_instance(plugin);
         if (ptr)
         {
             init_plugin(ptr);
             loaded_plugins[plugin] = std::move(ptr);
+            LOGD(output->to_string(), ": loaded ", plugin, " in ",
+                ms_since(plugin_start), "ms");
+            ++count;
         }
     }
+
+    if (count > 0)
+    {
+        LOGD(output->to_string(), ": loaded ", count, " plugins in ",
+            ms_since(start), "ms");
+    }
 }
 
 template<class T>
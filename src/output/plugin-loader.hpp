@@ -2,6 +2,7 @@
 #define PLUGIN_LOADER_HPP
 
 #include <vector>
+#include <string>
 #include <unordered_map>
 #include "wayfire/plugin.hpp"
 #include "config.h"
@@ -31,7 +32,6 @@ struct plugin_manager
 
     void deinit_plugins(bool unloadable);
 
-    wayfire_plugin load_plugin_from_file(std::string path);
     void load_static_plugins();
 
     void init_plugin(wayfire_plugin& plugin);
@@ -63,6 +63,57 @@ B union_cast(A object)
  */
 std::pair<void*, void*> get_new_instance_handle(const std::string& path);
 
+/**
+ * Keeps the dynamic plugins which are in use by any output.
+ *
+ * Each plugin file is opened and checked only once, no matter how many outputs
+ * instantiate it. The file is closed again when the last instance is destroyed.
+ */
+class plugin_registry_t
+{
+  public:
+    static plugin_registry_t& get();
+
+    /**
+     * @return The full paths of the plugins listed in core/plugins. The list is
+     *   resolved again only when the option changes.
+     */
+    const std::vector<std::string>& get_plugin_list();
+
+    /**
+     * Create a new instance of the plugin at @param path, opening the plugin
+     * file if it is not open yet.
+     *
+     * @return The new instance, or nullptr if the plugin could not be loaded.
+     */
+    wayfire_plugin create_instance(const std::string& path);
+
+    /**
+     * Release the plugin handle of a destroyed instance. Must be called after
+     * the instance has been deallocated.
+     */
+    void release(void *handle);
+
+  private:
+    plugin_registry_t();
+
+    struct entry_t
+    {
+        void *handle;
+        wayfire_plugin_load_func new_instance;
+        /** Number of live instances */
+        int refcount;
+    };
+
+    std::unordered_map<std::string, entry_t> plugins;
+    std::unordered_map<void*, std::string> handle_to_path;
+
+    wf::option_wrapper_t<std::string> plugins_opt;
+    std::string resolved_opt_value;
+    std::vector<std::string> resolved_plugins;
+    bool resolved = false;
+};
+
 /**
  * List the locations where wayfire's plugins are installed.
  * This function takes care of env variable WAYFIRE_PLUGIN_PATH,
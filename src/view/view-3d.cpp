@@ -175,7 +175,8 @@ class view_2d_render_instance_t :
     {
         // Untransformed bounding box
         auto bbox = self->get_children_bounding_box();
-        auto tex  = this->get_texture(target.scale);
+        auto tex  = self->use_thumbnail ?
+            this->get_texture_or_thumbnail(target.scale) : this->get_texture(target.scale);
 
         auto midpoint  = get_center(self->view->get_wm_geometry());
         auto center_at = glm::translate(glm::mat4(1.0),
@@ -390,7 +391,8 @@ class view_3d_render_instance_t :
                 });
 
         transform = target.transform * scale * translate * transform;
-        auto tex = get_texture(target.scale);
+        auto tex = self->use_thumbnail ?
+            get_texture_or_thumbnail(target.scale) : get_texture(target.scale);
 
         OpenGL::render_begin(target);
         for (auto& box : damage)
@@ -0,0 +1,100 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "scale-layout.hpp"
+
+using namespace wf::scale_layout;
+
+TEST_CASE("No views")
+{
+    auto layout = compute_layout({}, {0, 0, 1000, 1000}, 10);
+    REQUIRE(layout.slots.empty());
+    REQUIRE(layout.row_sizes.empty());
+}
+
+TEST_CASE("Single view fills the workarea")
+{
+    auto layout = compute_layout({{100, 100, 50, 50}}, {0, 0, 1000, 500}, 10);
+    REQUIRE(layout.row_sizes == std::vector<int>{1});
+    REQUIRE(layout.slots.size() == 1);
+
+    auto& slot = layout.slots[0];
+    REQUIRE(slot.index == 0);
+    REQUIRE(slot.row == 0);
+    REQUIRE(slot.col == 0);
+    REQUIRE(slot.x == doctest::Approx(10));
+    REQUIRE(slot.y == doctest::Approx(10));
+    REQUIRE(slot.width == doctest::Approx(980));
+    REQUIRE(slot.height == doctest::Approx(480));
+}
+
+TEST_CASE("Rows are split evenly with the remainder in the last row")
+{
+    /* 5 views: 2 rows (sqrt(6)), 3 views per row */
+    std::vector<wf::geometry_t> views(5, {0, 0, 100, 100});
+    auto layout = compute_layout(views, {0, 0, 1000, 1000}, 0);
+    REQUIRE(layout.row_sizes == std::vector<int>{3, 2});
+    REQUIRE(layout.slots.size() == 5);
+
+    for (size_t i = 0; i < layout.slots.size(); i++)
+    {
+        auto& slot = layout.slots[i];
+        int row = i < 3 ? 0 : 1;
+        int col = i < 3 ? i : i - 3;
+        REQUIRE(slot.row == row);
+        REQUIRE(slot.col == col);
+        REQUIRE(slot.height == doctest::Approx(500));
+        REQUIRE(slot.width == doctest::Approx(row == 0 ? 1000.0 / 3 : 500));
+        REQUIRE(slot.y == doctest::Approx(row * 500));
+        REQUIRE(slot.x == doctest::Approx(col * slot.width));
+    }
+}
+
+TEST_CASE("Rows are ordered by y, columns by x")
+{
+    std::vector<wf::geometry_t> views = {
+        {500, 600, 100, 100}, // bottom right
+        {0, 0, 100, 100}, // top left
+        {0, 600, 100, 100}, // bottom left
+        {500, 0, 100, 100}, // top right
+    };
+
+    auto layout = compute_layout(views, {0, 0, 1000, 1000}, 10);
+    REQUIRE(layout.row_sizes == std::vector<int>{2, 2});
+
+    std::vector<size_t> order;
+    for (auto& slot : layout.slots)
+    {
+        order.push_back(slot.index);
+    }
+
+    REQUIRE(order == std::vector<size_t>{1, 3, 2, 0});
+}
+
+TEST_CASE("Ties are broken by size")
+{
+    /* Views at the same position are ordered by their size */
+    std::vector<wf::geometry_t> views = {
+        {0, 0, 200, 100},
+        {0, 0, 100, 100},
+    };
+
+    auto layout = compute_layout(views, {0, 0, 1000, 1000}, 10);
+    REQUIRE(layout.row_sizes == std::vector<int>{2});
+    REQUIRE(layout.slots[0].index == 1);
+    REQUIRE(layout.slots[1].index == 0);
+}
+
+TEST_CASE("The layout is deterministic")
+{
+    std::vector<wf::geometry_t> views;
+    for (int i = 0; i < 20; i++)
+    {
+        views.push_back({(i * 37) % 500, (i * 91) % 400, 100 + i, 80 + i});
+    }
+
+    auto a = compute_layout(views, {0, 0, 1920, 1080}, 20);
+    auto b = compute_layout(views, {0, 0, 1920, 1080}, 20);
+    REQUIRE(a.slots == b.slots);
+    REQUIRE(a.row_sizes == b.row_sizes);
+}
@@ -0,0 +1,323 @@
+/**
+ * Builds simple-tile trees of split_node_t and view_node_t with hundreds of
+ * leaves on a mock output, and counts how many views geometry_batch_t
+ * configures when a split is resized.
+ *
+ * The scenarios are a resize of the root (for ex. a changed workarea), and
+ * an interactive resize of two neighbouring subtrees, at the top of the tree
+ * and at the bottom of it.
+ *
+ * Usage: tile-tree-benchmark [iterations]
+ */
+#include "tree.hpp"
+#include "bench-util.hpp"
+#include "../mock-core.hpp"
+
+#include <wayfire/compositor-view.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/workspace-manager.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace
+{
+template<class Type>
+void add_option(const std::string& section_name, const std::string& name, Type value)
+{
+    auto section = std::make_shared<wf::config::section_t>(section_name);
+    section->register_new_option(
+        std::make_shared<wf::config::option_t<Type>>(name, value));
+    mock_core().config.merge_section(section);
+}
+
+/** A 1920x1080 output with a 3x3 workspace grid, without any plugins. */
+class mock_output_t : public wf::output_t
+{
+  public:
+    mock_output_t()
+    {
+        this->handle    = nullptr;
+        this->workspace = std::make_unique<wf::workspace_manager>(this);
+    }
+
+    wf::dimensions_t get_screen_size() const override
+    {
+        return {1920, 1080};
+    }
+
+    std::shared_ptr<wf::scene::output_node_t> node_for_layer(
+        wf::scene::layer layer) const override
+    {
+        return nullptr;
+    }
+
+    wf::scene::floating_inner_ptr get_wset() const override
+    {
+        return nullptr;
+    }
+
+    bool can_activate_plugin(const wf::plugin_grab_interface_uptr& owner,
+        uint32_t flags) override
+    {
+        return false;
+    }
+
+    bool can_activate_plugin(uint32_t caps, uint32_t flags) override
+    {
+        return false;
+    }
+
+    bool activate_plugin(const wf::plugin_grab_interface_uptr& owner,
+        uint32_t flags) override
+    {
+        return false;
+    }
+
+    bool deactivate_plugin(const wf::plugin_grab_interface_uptr& owner) override
+    {
+        return false;
+    }
+
+    void cancel_active_plugins() override
+    {}
+
+    bool is_plugin_active(std::string owner_name) const override
+    {
+        return false;
+    }
+
+    bool call_plugin(const std::string& activator,
+        const wf::activator_data_t& data) const override
+    {
+        return false;
+    }
+
+    wayfire_view get_active_view() const override
+    {
+        return nullptr;
+    }
+
+    void focus_view(wayfire_view v, bool raise) override
+    {}
+
+    void focus_node(wf::scene::node_ptr new_focus) override
+    {}
+
+    uint64_t get_last_focus_timestamp() const override
+    {
+        return 0;
+    }
+
+    void refocus() override
+    {}
+
+    wf::binding_t *add_key(wf::option_sptr_t<wf::keybinding_t> key,
+        wf::key_callback*) override
+    {
+        return nullptr;
+    }
+
+    wf::binding_t *add_axis(wf::option_sptr_t<wf::keybinding_t> axis,
+        wf::axis_callback*) override
+    {
+        return nullptr;
+    }
+
+    wf::binding_t *add_button(wf::option_sptr_t<wf::buttonbinding_t> button,
+        wf::button_callback*) override
+    {
+        return nullptr;
+    }
+
+    wf::binding_t *add_activator(wf::option_sptr_t<wf::activatorbinding_t> activator,
+        wf::activator_callback*) override
+    {
+        return nullptr;
+    }
+
+    void rem_binding(wf::binding_t *binding) override
+    {}
+
+    void rem_binding(void *callback) override
+    {}
+};
+
+/**
+ * A mapped view which only remembers the geometry it was configured with, and
+ * counts how many times it was configured.
+ */
+class mock_view_t : public wf::color_rect_view_t
+{
+  public:
+    static size_t configured;
+
+    mock_view_t(wf::output_t *output) : output(output)
+    {
+        initialize();
+    }
+
+    wf::output_t *get_output() override
+    {
+        return output;
+    }
+
+    void set_geometry(wf::geometry_t g) override
+    {
+        this->geometry = g;
+        ++configured;
+    }
+
+    void set_tiled(uint32_t edges) override
+    {
+        this->tiled_edges = edges;
+    }
+
+  private:
+    wf::output_t *output;
+};
+
+size_t mock_view_t::configured = 0;
+
+/** Add leaves to the split, in subtrees of 2-4 children with alternating direction. */
+void populate(wf::tile::split_node_t& split, size_t leaves, wf::output_t *output,
+    std::vector<std::unique_ptr<mock_view_t>>& views, std::mt19937& gen)
+{
+    std::uniform_int_distribution<size_t> fanout(2, 4);
+    size_t count = std::min(fanout(gen), leaves);
+    auto child_direction = (split.get_split_direction() == wf::tile::SPLIT_VERTICAL) ?
+        wf::tile::SPLIT_HORIZONTAL : wf::tile::SPLIT_VERTICAL;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t share = leaves / count + (i < leaves % count);
+        if (share == 1)
+        {
+            views.push_back(std::make_unique<mock_view_t>(output));
+            split.add_child(std::make_unique<wf::tile::view_node_t>(views.back().get()));
+        } else
+        {
+            split.add_child(std::make_unique<wf::tile::split_node_t>(child_direction));
+            populate(*split.children.back()->as_split_node(), share, output, views, gen);
+        }
+    }
+}
+
+/**
+ * A split at the bottom of the tree whose first two children are leaves. Trees
+ * built by populate() always have one, as every split with two leaves is one.
+ */
+nonstd::observer_ptr<wf::tile::split_node_t> bottom_leaf_pair(
+    nonstd::observer_ptr<wf::tile::split_node_t> split)
+{
+    for (auto& child : split->children)
+    {
+        if (child->as_split_node())
+        {
+            if (auto result = bottom_leaf_pair(child->as_split_node()))
+            {
+                return result;
+            }
+        }
+    }
+
+    if ((split->children.size() >= 2) &&
+        split->children[0]->as_view_node() && split->children[1]->as_view_node())
+    {
+        return split;
+    }
+
+    return nullptr;
+}
+
+/**
+ * Move the border between the first two children of the split by delta, like
+ * resize_view_controller_t::input_motion() does.
+ *
+ * @return The number of views configured.
+ */
+size_t resize_pair(wf::tile::split_node_t& split, int delta)
+{
+    auto& first  = split.children[0];
+    auto& second = split.children[1];
+    auto g1 = first->geometry;
+    auto g2 = second->geometry;
+    if (split.get_split_direction() == wf::tile::SPLIT_VERTICAL)
+    {
+        g1.width += delta;
+        g2.x     += delta;
+        g2.width -= delta;
+    } else
+    {
+        g1.height += delta;
+        g2.y += delta;
+        g2.height -= delta;
+    }
+
+    mock_view_t::configured = 0;
+    {
+        wf::tile::geometry_batch_t batch;
+        first->set_geometry(g1);
+        second->set_geometry(g2);
+    }
+
+    return mock_view_t::configured;
+}
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 1000;
+
+    add_option<int>("core", "vwidth", 3);
+    add_option<int>("core", "vheight", 3);
+    add_option<bool>("workarounds", "remove_output_limits", false);
+    add_option<int>("simple-tile", "animation_duration", 0);
+
+    mock_output_t output;
+    const wf::geometry_t workarea = {0, 0, 1920, 1080};
+
+    for (size_t count : {100, 300, 600})
+    {
+        std::mt19937 gen(count);
+        std::vector<std::unique_ptr<mock_view_t>> views;
+        views.push_back(std::make_unique<mock_view_t>(&output));
+
+        auto root = std::make_unique<wf::tile::split_node_t>(wf::tile::SPLIT_VERTICAL);
+        root->set_geometry(workarea);
+        root->add_child(std::make_unique<wf::tile::view_node_t>(views.front().get()));
+        populate(*root, count - 1, &output, views, gen);
+
+        /* A smaller root, as when a panel reserves space, and back */
+        mock_view_t::configured = 0;
+        root->set_geometry({0, 30, 1920, 1050});
+        size_t root_configured = mock_view_t::configured;
+        double root_us = wf::bench::average_us(iterations, [&, i = 0] () mutable
+        {
+            root->set_geometry((i++ % 2) ? wf::geometry_t{0, 30, 1920, 1050} : workarea);
+        });
+
+        size_t top_configured = resize_pair(*root, 20);
+        double top_us = wf::bench::average_us(iterations, [&, i = 0] () mutable
+        {
+            resize_pair(*root, (i++ % 2) ? 20 : -20);
+        });
+
+        auto leaf_split = bottom_leaf_pair(root);
+        size_t leaf_configured = resize_pair(*leaf_split, 10);
+        double leaf_us = wf::bench::average_us(iterations, [&, i = 0] () mutable
+        {
+            resize_pair(*leaf_split, (i++ % 2) ? 10 : -10);
+        });
+
+        std::cout << views.size() << " views: root resize configures " <<
+            root_configured << " (" << root_us << " us), top-level pair " <<
+            top_configured << " (" << top_us << " us), leaf pair " <<
+            leaf_configured << " (" << leaf_us << " us)" << std::endl;
+
+        /* The nodes refer to the views, destroy them first */
+        root.reset();
+    }
+
+    return 0;
+}
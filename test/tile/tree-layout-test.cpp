@@ -0,0 +1,105 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "tree-layout.hpp"
+#include <cstdlib>
+
+using namespace wf::tile;
+
+/* The children must cover the available geometry without gaps or overlaps */
+static void require_tiles(wf::geometry_t available, split_direction_t direction,
+    const std::vector<wf::geometry_t>& children)
+{
+    int32_t pos = (direction == SPLIT_HORIZONTAL) ? available.y : available.x;
+    for (auto& child : children)
+    {
+        if (direction == SPLIT_HORIZONTAL)
+        {
+            REQUIRE(child.x == available.x);
+            REQUIRE(child.width == available.width);
+            REQUIRE(child.y == pos);
+            pos += child.height;
+        } else
+        {
+            REQUIRE(child.y == available.y);
+            REQUIRE(child.height == available.height);
+            REQUIRE(child.x == pos);
+            pos += child.width;
+        }
+    }
+
+    REQUIRE(pos == (direction == SPLIT_HORIZONTAL ?
+        available.y + available.height : available.x + available.width));
+}
+
+TEST_CASE("Splittable size")
+{
+    wf::geometry_t g = {1, 2, 30, 40};
+    REQUIRE(get_splittable_size(g, SPLIT_HORIZONTAL) == 40);
+    REQUIRE(get_splittable_size(g, SPLIT_VERTICAL) == 30);
+}
+
+TEST_CASE("Children keep their proportions")
+{
+    std::vector<wf::geometry_t> children = {
+        {0, 0, 100, 10},
+        {0, 0, 300, 10},
+    };
+
+    wf::geometry_t available = {50, 20, 800, 600};
+    layout_split(available, SPLIT_VERTICAL, children);
+    require_tiles(available, SPLIT_VERTICAL, children);
+    REQUIRE(children[0].width == 200);
+    REQUIRE(children[1].width == 600);
+
+    /* Only the size in the split direction matters */
+    layout_split(available, SPLIT_HORIZONTAL, children);
+    require_tiles(available, SPLIT_HORIZONTAL, children);
+    REQUIRE(children[0].height == 300);
+    REQUIRE(children[1].height == 300);
+}
+
+TEST_CASE("Rounding leaves no gaps")
+{
+    for (int count = 1; count <= 13; count++)
+    {
+        for (int total : {97, 100, 1079, 1080})
+        {
+            std::vector<wf::geometry_t> children(count, {0, 0, 10, 10});
+            wf::geometry_t available = {7, 3, total, total + 1};
+            layout_split(available, SPLIT_VERTICAL, children);
+            require_tiles(available, SPLIT_VERTICAL, children);
+
+            /* Equal children differ by at most a pixel */
+            for (auto& child : children)
+            {
+                REQUIRE(std::abs(child.width - total / count) <= 1);
+            }
+
+            layout_split(available, SPLIT_HORIZONTAL, children);
+            require_tiles(available, SPLIT_HORIZONTAL, children);
+        }
+    }
+}
+
+TEST_CASE("Relayout is stable")
+{
+    std::vector<wf::geometry_t> children = {
+        {0, 0, 333, 333},
+        {0, 0, 333, 333},
+        {0, 0, 334, 334},
+    };
+
+    wf::geometry_t available = {0, 0, 1000, 1000};
+    layout_split(available, SPLIT_VERTICAL, children);
+    auto first = children;
+
+    /* Laying out again in the same geometry does not change anything, so that
+     * the views do not have to be configured again */
+    layout_split(available, SPLIT_VERTICAL, children);
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        REQUIRE(children[i].x == first[i].x);
+        REQUIRE(children[i].width == first[i].width);
+    }
+}